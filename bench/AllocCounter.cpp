@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "AllocCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+    #define ALLOCCOUNTER_GLIBC
+#endif
+
+namespace {
+
+std::atomic<qint64> allocCount(0);
+
+} // namespace
+
+#ifdef ALLOCCOUNTER_GLIBC
+
+// The program's definitions take precedence over the C library's for all
+// code in the process, including Qt. Forward to glibc's implementation.
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#endif // ALLOCCOUNTER_GLIBC
+
+bool AllocCounter::available()
+{
+#ifdef ALLOCCOUNTER_GLIBC
+    return true;
+#else
+    return false;
+#endif
+}
+
+qint64 AllocCounter::count()
+{
+    if (!available()) { return -1; }
+    return allocCount.load(std::memory_order_relaxed);
+}
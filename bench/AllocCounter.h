@@ -0,0 +1,38 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <QtGlobal>
+
+/* Counts heap allocations (malloc, calloc and realloc calls, which new and
+ * the Qt containers end up in) of the whole process, by replacing malloc.
+ * Only done with glibc, elsewhere count() returns -1. */
+
+class AllocCounter
+{
+public:
+    static bool available();
+    static qint64 count();
+};
+
+#endif // ALLOCCOUNTER_H
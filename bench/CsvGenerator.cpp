@@ -0,0 +1,98 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "CsvGenerator.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QStringList>
+
+namespace {
+
+// Written in pieces so large files don't have to fit in memory
+const int writeSize = 1024 * 1024;
+
+} // namespace
+
+qint64 CsvGenerator::write(const QString& filename, const Options& options,
+                           QString& error)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = file.errorString();
+        return -1;
+    }
+
+    QRandomGenerator rand(options.seed);
+
+    // Bool columns are spread evenly over the row
+    QVector<bool> boolCols(options.cols);
+    int boolCount = qRound(options.cols * options.boolFraction);
+    for (int i = 0; i < boolCount; i++) {
+        boolCols[int(qint64(i) * options.cols / boolCount)] = true;
+    }
+
+    QByteArray sep(options.padding + 1, options.separator);
+
+    QByteArray data;
+    data.reserve(writeSize + 4096);
+    data.append(headings(options.cols).join(options.separator).toUtf8());
+    data.append('\n');
+
+    for (int row = 0; row < options.rows; row++) {
+        for (int col = 0; col < options.cols; col++) {
+            if (col > 0) { data.append(sep); }
+            if ((options.errorDensity > 0)
+                    && (rand.generateDouble() < options.errorDensity)) {
+                data.append("n/a");
+            } else if (boolCols[col]) {
+                data.append(rand.generate() & 1 ? '1' : '0');
+            } else {
+                data.append(QByteArray::number(
+                                (rand.generateDouble() - 0.5) * 2000, 'f', 4));
+            }
+        }
+        data.append('\n');
+
+        if (data.size() >= writeSize) {
+            if (file.write(data) != data.size()) {
+                error = file.errorString();
+                return -1;
+            }
+            data.resize(0);
+        }
+    }
+    if (file.write(data) != data.size()) {
+        error = file.errorString();
+        return -1;
+    }
+
+    return file.size();
+}
+
+QStringList CsvGenerator::headings(int cols)
+{
+    QStringList ret;
+    for (int col = 0; col < cols; col++) {
+        ret.append(QString("col%1").arg(col + 1));
+    }
+    return ret;
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef CSVGENERATOR_H
+#define CSVGENERATOR_H
+
+#include <QString>
+
+/* CsvGenerator writes synthetic CSV files for benchmarking the import. The
+ * file has a heading line followed by rows of random values. Columns are
+ * either floats or bools (0 and 1), and a fraction of the fields can be made
+ * text that fails conversion. The same options always give the same file. */
+
+class CsvGenerator
+{
+public:
+    struct Options
+    {
+        int rows = 100000;
+        int cols = 16;
+        char separator = ',';
+        // Extra separators written between fields, for files read with
+        // combineSeparators, e.g. space-aligned columns
+        int padding = 0;
+        // Fraction of fields that are not numbers
+        double errorDensity = 0;
+        // Fraction of columns holding bools instead of floats
+        double boolFraction = 0;
+        quint32 seed = 1234;
+    };
+
+    // Returns the size of the file written, or -1 on error
+    static qint64 write(const QString& filename, const Options& options,
+                        QString& error);
+
+    static QStringList headings(int cols);
+};
+
+#endif // CSVGENERATOR_H
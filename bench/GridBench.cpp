@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "GridBench.h"
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+
+#include <iostream>
+
+void GridBench::run()
+{
+    foreach (int count, QList<int>({10000, 100000, 1000000})) {
+        foreach (Distribution dist, QList<Distribution>({Uniform, Clustered, Line})) {
+            QVector<QPointF> coords = generate(dist, count);
+            std::cout << QString("Grid search: %1 points %2")
+                         .arg(count).arg(distributionName(dist))
+                         .toStdString() << std::endl;
+            runCase("adaptive", coords, 0);
+            runCase("fixed", coords, 100);
+        }
+    }
+}
+
+QVector<QPointF> GridBench::generate(Distribution distribution, int count)
+{
+    QRandomGenerator rand(1234);
+    QVector<QPointF> coords(count);
+
+    switch (distribution) {
+    case Uniform:
+        for (int i = 0; i < count; i++) {
+            coords[i] = QPointF(rand.generateDouble(), rand.generateDouble());
+        }
+        break;
+    case Clustered: {
+        // Most points in a few small clusters, the rest spread out
+        const int clusters = 8;
+        QVector<QPointF> centres(clusters);
+        for (int c = 0; c < clusters; c++) {
+            centres[c] = QPointF(rand.generateDouble(), rand.generateDouble());
+        }
+        for (int i = 0; i < count; i++) {
+            if (i % 10 == 0) {
+                coords[i] = QPointF(rand.generateDouble(), rand.generateDouble());
+                continue;
+            }
+            // Box-Muller transform for a normal distribution
+            double r = 0.01 * qSqrt(-2 * qLn(1 - rand.generateDouble()));
+            double a = 2 * M_PI * rand.generateDouble();
+            const QPointF& centre = centres[i % clusters];
+            coords[i] = QPointF(centre.x() + r * qCos(a),
+                                centre.y() + r * qSin(a));
+        }
+        break;
+    }
+    case Line:
+        // Like a GPS track: a meandering path with a little noise
+        for (int i = 0; i < count; i++) {
+            double t = double(i) / count;
+            coords[i] = QPointF(t + 0.001 * rand.generateDouble(),
+                                0.5 + 0.4 * qSin(t * 20)
+                                + 0.001 * rand.generateDouble());
+        }
+        break;
+    }
+
+    return coords;
+}
+
+QString GridBench::distributionName(Distribution distribution)
+{
+    switch (distribution) {
+    case Uniform: return "uniform";
+    case Clustered: return "clustered";
+    case Line: return "line";
+    }
+    return QString();
+}
+
+void GridBench::runCase(const QString& name, const QVector<QPointF>& coords,
+                        int n)
+{
+    const int queries = 10000;
+    const int startSizePx = 50;
+    const int minSizePx = 4;
+
+    double left = coords.value(0).x();
+    double right = left;
+    double top = coords.value(0).y();
+    double bottom = top;
+    foreach (const QPointF& p, coords) {
+        left = qMin(left, p.x());
+        right = qMax(right, p.x());
+        top = qMin(top, p.y());
+        bottom = qMax(bottom, p.y());
+    }
+    QRectF bounds(QPointF(left, top), QPointF(right, bottom));
+
+    GridHash grid;
+    grid.n = n;
+    QElapsedTimer timer;
+    timer.start();
+    grid.build(bounds, coords);
+    qint64 buildNs = timer.nsecsElapsed();
+
+    // Pixels per coordinate unit, as for a plot of the bounds
+    double sx = pixelSize / bounds.width();
+    double sy = pixelSize / bounds.height();
+
+    QRandomGenerator rand(5678);
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+    qint64 totalScanned = 0;
+    qint64 maxScanned = 0;
+    int found = 0;
+    for (int q = 0; q < queries; q++) {
+        QPointF mouse(rand.generateDouble() * pixelSize,
+                      rand.generateDouble() * pixelSize);
+
+        timer.start();
+        qint64 scanned = 0;
+        bool valid = false;
+        double closestDistSqr = 0;
+
+        // As Plot::findClosestCoord
+        QSizeF cell = grid.cellSize();
+        int px = qBound(minSizePx,
+                        (int)qMax(cell.width() * sx, cell.height() * sy),
+                        startSizePx);
+        while (!valid) {
+            QRectF searchRect(QPointF(left + (mouse.x() - px / 2.0) / sx,
+                                      top + (mouse.y() - px / 2.0) / sy),
+                              QSizeF(px / sx, px / sy));
+            double limitDistSqr = double(px) * px;
+            bool maxedOut = grid.visit(searchRect, ClosestXY,
+                                       [&](const QPointF& coord, int)
+            {
+                scanned++;
+                double dx = mouse.x() - (coord.x() - left) * sx;
+                double dy = mouse.y() - (coord.y() - top) * sy;
+                double distSqr = dx * dx + dy * dy;
+                if ((!valid || (distSqr < closestDistSqr))
+                        && (distSqr <= limitDistSqr)) {
+                    closestDistSqr = distSqr;
+                    valid = true;
+                }
+            });
+            if (maxedOut) { break; }
+            px *= 2;
+        }
+
+        qint64 ns = timer.nsecsElapsed();
+        totalNs += ns;
+        maxNs = qMax(maxNs, ns);
+        totalScanned += scanned;
+        maxScanned = qMax(maxScanned, scanned);
+        if (valid) { found++; }
+    }
+
+    std::cout << QString("  %1 %2x%2 cells  build %3 ms  %4 MB  "
+                         "query %5 us mean %6 us max  "
+                         "scanned %7 mean %8 max  (%9 found)")
+                 .arg(name, -9)
+                 .arg(grid.resolution(), 4)
+                 .arg(buildNs / 1e6, 7, 'f', 1)
+                 .arg(grid.memoryUsage() / 1e6, 6, 'f', 1)
+                 .arg(totalNs / 1e3 / queries, 7, 'f', 1)
+                 .arg(maxNs / 1e3, 8, 'f', 1)
+                 .arg(double(totalScanned) / queries, 8, 'f', 0)
+                 .arg(maxScanned, 8)
+                 .arg(found)
+                 .toStdString() << std::endl;
+}
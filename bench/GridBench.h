@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef GRIDBENCH_H
+#define GRIDBENCH_H
+
+#include "GridHash.h"
+
+#include <QString>
+#include <QVector>
+
+/* GridBench measures building GridHash and finding the closest point to the
+ * mouse with it, the way Plot::findClosestCoord does, for points spread
+ * uniformly, in clusters and along a line. The plot is taken to show all the
+ * points in pixelSize x pixelSize pixels, and the mouse is put at random
+ * positions in it.
+ *
+ * Each case is run with the grid resolution chosen from the points and with
+ * the fixed 100 x 100 grid used before, and prints the resolution, build
+ * time, memory, and the mean and worst query time and points scanned. The
+ * worst case is what makes the crosshair feel slow. */
+
+class GridBench
+{
+public:
+    enum Distribution { Uniform, Clustered, Line };
+
+    // Runs all cases, printing a line per case
+    static void run();
+
+private:
+    static const int pixelSize = 1000;
+
+    static QVector<QPointF> generate(Distribution distribution, int count);
+    static QString distributionName(Distribution distribution);
+    static void runCase(const QString& name, const QVector<QPointF>& coords,
+                        int n);
+};
+
+#endif // GRIDBENCH_H
@@ -0,0 +1,294 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "ImportBench.h"
+#include "AllocCounter.h"
+#include "csvimporter.h"
+#include "ProcessMemory.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+
+#include <iostream>
+
+void ImportBench::addCaseOptions(QCommandLineParser& parser)
+{
+    parser.addOptions({
+        {"rows", "Rows of the generated file.", "count", "100000"},
+        {"cols", "Columns of the generated file.", "count", "16"},
+        {"separator", "Separator: comma, tab, semicolon or space.",
+         "name", "comma"},
+        {"combine", "Import with combineSeparators."},
+        {"padding", "Extra separators between fields.", "count", "0"},
+        {"errors", "Fraction of fields that are not numbers.",
+         "fraction", "0"},
+        {"bools", "Fraction of columns holding bools.", "fraction", "0"},
+        {"mode", "Import mode: mapped, streamed or lazy.", "name", "mapped"},
+        {"name", "Name of the case in the output.", "name", "baseline"},
+    });
+}
+
+ImportBench::Case ImportBench::caseFromOptions(const QCommandLineParser& parser)
+{
+    Case c;
+    c.name = parser.value("name");
+    c.csv.rows = parser.value("rows").toInt();
+    c.csv.cols = qMax(1, parser.value("cols").toInt());
+    c.csv.separator = separatorFromName(parser.value("separator"));
+    c.csv.padding = parser.value("padding").toInt();
+    c.csv.errorDensity = parser.value("errors").toDouble();
+    c.csv.boolFraction = parser.value("bools").toDouble();
+    c.combineSeparators = parser.isSet("combine");
+    c.mode = modeFromName(parser.value("mode"));
+    return c;
+}
+
+int ImportBench::runSuite(const QString& program, int baselineRows)
+{
+    QList<Case> cases = suiteCases(baselineRows);
+    int failed = 0;
+
+    for (int i = 0; i < cases.count(); i++) {
+        const Case& c = cases[i];
+        std::cerr << QString("Import case %1/%2: %3")
+                     .arg(i + 1).arg(cases.count()).arg(c.name)
+                     .toStdString() << std::endl;
+
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(program, QStringList{"--import-case"} + caseArguments(c));
+        process.waitForFinished(-1);
+        std::cout << process.readAllStandardOutput().toStdString() << std::flush;
+
+        bool ok = (process.exitStatus() == QProcess::NormalExit)
+                && (process.exitCode() == 0);
+        if (!ok) {
+            std::cerr << "  Failed" << std::endl;
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+bool ImportBench::runCase(const Case& c)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::cerr << "Could not create temporary directory" << std::endl;
+        return false;
+    }
+    QString filename = dir.filePath("bench.csv");
+    QString error;
+    qint64 bytes = CsvGenerator::write(filename, c.csv, error);
+    if (bytes < 0) {
+        std::cerr << "Could not write CSV file: " << error.toStdString()
+                  << std::endl;
+        return false;
+    }
+
+    Csv::FileInfo info;
+    info.filename = filename;
+    info.headings = CsvGenerator::headings(c.csv.cols);
+    info.dataStartRow = 1;
+    info.separator = c.csv.separator;
+    info.combineSeparators = c.combineSeparators;
+    info.memoryMap = (c.mode != ModeStreamed);
+    info.useCache = false;
+    info.lazy = (c.mode == ModeLazy);
+
+    CsvImporter importer;
+    QEventLoop loop;
+    QObject::connect(&importer, &CsvImporter::importFinished,
+                     &loop, &QEventLoop::quit);
+
+    qint64 rssBefore = ProcessMemory::current();
+    qint64 allocsBefore = AllocCounter::count();
+    QElapsedTimer timer;
+    timer.start();
+
+    CsvPtr csv = importer.importCsv(info);
+    loop.exec();
+    qint64 importNs = timer.nsecsElapsed();
+
+    if (!csv->importInfo.success) {
+        std::cerr << "Import failed: " << csv->importInfo.info.toStdString()
+                  << std::endl;
+        return false;
+    }
+
+    // Lazily imported columns are only read when used, so use them all
+    // to compare with the other modes
+    timer.start();
+    if (c.mode == ModeLazy) {
+        for (int col = 1; col < csv->matrix->colCount(); col++) {
+            csv->matrix->columnView(col);
+        }
+    }
+    qint64 readNs = timer.nsecsElapsed();
+
+    qint64 allocs = -1;
+    if (AllocCounter::available()) {
+        allocs = AllocCounter::count() - allocsBefore;
+    }
+    int rows = csv->matrix->rowCount();
+    double secs = (importNs + readNs) / 1e9;
+
+    QJsonObject result;
+    result["name"] = c.name;
+    result["mode"] = modeName(c.mode);
+    result["cols"] = c.csv.cols;
+    result["separator"] = separatorName(c.csv.separator);
+    result["combine"] = c.combineSeparators;
+    result["padding"] = c.csv.padding;
+    result["errorDensity"] = c.csv.errorDensity;
+    result["boolFraction"] = c.csv.boolFraction;
+    result["bytes"] = bytes;
+    result["rows"] = rows;
+    result["errors"] = csv->matrix->errorCount();
+    result["importMs"] = importNs / 1e6;
+    result["readMs"] = readNs / 1e6;
+    result["mbPerSec"] = bytes / secs / 1e6;
+    result["rowsPerSec"] = rows / secs;
+    result["rssBefore"] = rssBefore;
+    result["peakRss"] = ProcessMemory::peak();
+    result["allocs"] = allocs;
+    result["allocsPerRow"] = ((allocs >= 0) && (rows > 0))
+            ? double(allocs) / rows : -1;
+
+    std::cout << QJsonDocument(result).toJson(QJsonDocument::Compact)
+                 .toStdString() << std::endl;
+    return true;
+}
+
+QList<ImportBench::Case> ImportBench::suiteCases(int baselineRows)
+{
+    Case baseline;
+    baseline.name = "baseline";
+    baseline.csv.rows = baselineRows;
+
+    QList<Case> cases {baseline};
+    Case c;
+
+    // Same number of fields for each width
+    foreach (int cols, QList<int>({2, 64, 256})) {
+        c = baseline;
+        c.name = QString("cols=%1").arg(cols);
+        c.csv.cols = cols;
+        c.csv.rows = int(qint64(baselineRows) * baseline.csv.cols / cols);
+        cases.append(c);
+    }
+
+    foreach (char separator, QList<char>({'\t', ';'})) {
+        c = baseline;
+        c.name = "separator=" + separatorName(separator);
+        c.csv.separator = separator;
+        cases.append(c);
+    }
+
+    foreach (int padding, QList<int>({0, 3})) {
+        c = baseline;
+        c.name = QString("combine,padding=%1").arg(padding);
+        c.csv.separator = ' ';
+        c.csv.padding = padding;
+        c.combineSeparators = true;
+        cases.append(c);
+    }
+
+    foreach (double errors, QList<double>({0.001, 0.05})) {
+        c = baseline;
+        c.name = QString("errors=%1").arg(errors);
+        c.csv.errorDensity = errors;
+        cases.append(c);
+    }
+
+    foreach (double bools, QList<double>({0.5, 1})) {
+        c = baseline;
+        c.name = QString("bools=%1").arg(bools);
+        c.csv.boolFraction = bools;
+        cases.append(c);
+    }
+
+    foreach (Mode mode, QList<Mode>({ModeStreamed, ModeLazy})) {
+        c = baseline;
+        c.name = "mode=" + modeName(mode);
+        c.mode = mode;
+        cases.append(c);
+    }
+
+    return cases;
+}
+
+QStringList ImportBench::caseArguments(const Case& c)
+{
+    QStringList args {
+        "--name", c.name,
+        "--rows", QString::number(c.csv.rows),
+        "--cols", QString::number(c.csv.cols),
+        "--separator", separatorName(c.csv.separator),
+        "--padding", QString::number(c.csv.padding),
+        "--errors", QString::number(c.csv.errorDensity),
+        "--bools", QString::number(c.csv.boolFraction),
+        "--mode", modeName(c.mode),
+    };
+    if (c.combineSeparators) {
+        args.append("--combine");
+    }
+    return args;
+}
+
+QString ImportBench::separatorName(char separator)
+{
+    switch (separator) {
+    case '\t': return "tab";
+    case ';': return "semicolon";
+    case ' ': return "space";
+    default: return "comma";
+    }
+}
+
+char ImportBench::separatorFromName(const QString& name)
+{
+    if (name == "tab") { return '\t'; }
+    if (name == "semicolon") { return ';'; }
+    if (name == "space") { return ' '; }
+    return ',';
+}
+
+QString ImportBench::modeName(Mode mode)
+{
+    switch (mode) {
+    case ModeStreamed: return "streamed";
+    case ModeLazy: return "lazy";
+    default: return "mapped";
+    }
+}
+
+ImportBench::Mode ImportBench::modeFromName(const QString& name)
+{
+    if (name == "streamed") { return ModeStreamed; }
+    if (name == "lazy") { return ModeLazy; }
+    return ModeMapped;
+}
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef IMPORTBENCH_H
+#define IMPORTBENCH_H
+
+#include "CsvGenerator.h"
+
+#include <QCommandLineParser>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/* ImportBench measures the import of generated CSV files through CsvImporter
+ * and Matrix, as the application does it, but without GUI.
+ *
+ * The suite runs each case in a separate process (this program with
+ * --import-case and the case options), so the peak memory of a case isn't
+ * that of an earlier, larger one. Each case prints one line of JSON with the
+ * case options and the results:
+ *   bytes, rows         Size of the file
+ *   importMs            Until CsvImporter finished
+ *   readMs              Reading all columns afterwards (lazy mode only)
+ *   mbPerSec, rowsPerSec  Over import and read time
+ *   rssBefore, peakRss  Resident memory before the import and peak, in bytes
+ *   allocs, allocsPerRow  Heap allocations during import and read (-1 if
+ *                       not counted on this platform) */
+
+class ImportBench
+{
+public:
+    enum Mode { ModeMapped, ModeStreamed, ModeLazy };
+
+    struct Case
+    {
+        // What is varied compared to the baseline, for reading the results
+        QString name;
+        CsvGenerator::Options csv;
+        bool combineSeparators = false;
+        Mode mode = ModeMapped;
+    };
+
+    static void addCaseOptions(QCommandLineParser& parser);
+    static Case caseFromOptions(const QCommandLineParser& parser);
+
+    // Runs all cases with baselineRows rows in the baseline case. Returns
+    // the number of cases that failed.
+    static int runSuite(const QString& program, int baselineRows);
+    // Runs a single case in this process. Returns false on error.
+    static bool runCase(const Case& c);
+
+private:
+    static QList<Case> suiteCases(int baselineRows);
+    static QStringList caseArguments(const Case& c);
+    static QString separatorName(char separator);
+    static char separatorFromName(const QString& name);
+    static QString modeName(Mode mode);
+    static Mode modeFromName(const QString& name);
+};
+
+#endif // IMPORTBENCH_H
@@ -0,0 +1,69 @@
+#-------------------------------------------------
+#
+# GidPlot benchmarks
+#
+# Build and run separately from the main application:
+#   qmake bench.pro && make && ./gidplot_bench
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+QT       -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = gidplot_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../src
+
+# Process memory info (ProcessMemory)
+win32: LIBS += -lpsapi
+
+# The import suite uses plain CSV files only, so CompressedFile and
+# ArrowSource are built without their libraries.
+SOURCES += \
+    AllocCounter.cpp \
+    CsvGenerator.cpp \
+    GridBench.cpp \
+    ImportBench.cpp \
+    main.cpp \
+    ../src/ArrowSource.cpp \
+    ../src/ClosestKernel.cpp \
+    ../src/Column.cpp \
+    ../src/CompressedFile.cpp \
+    ../src/CsvCache.cpp \
+    ../src/CsvScanner.cpp \
+    ../src/CsvSource.cpp \
+    ../src/GridHash.cpp \
+    ../src/NumberParser.cpp \
+    ../src/ProcessMemory.cpp \
+    ../src/Range.cpp \
+    ../src/Timestamp.cpp \
+    ../src/csv.cpp \
+    ../src/csvimporter.cpp \
+    ../src/matrix.cpp
+
+HEADERS += \
+    AllocCounter.h \
+    CsvGenerator.h \
+    GridBench.h \
+    ImportBench.h \
+    ../src/ArrowSource.h \
+    ../src/ByteSpan.h \
+    ../src/ClosestKernel.h \
+    ../src/Column.h \
+    ../src/ColumnSource.h \
+    ../src/CompressedFile.h \
+    ../src/CsvCache.h \
+    ../src/CsvScanner.h \
+    ../src/CsvSource.h \
+    ../src/GridHash.h \
+    ../src/NumberParser.h \
+    ../src/ProcessMemory.h \
+    ../src/Range.h \
+    ../src/Timestamp.h \
+    ../src/csv.h \
+    ../src/csvimporter.h \
+    ../src/matrix.h
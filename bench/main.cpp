@@ -0,0 +1,354 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "ClosestKernel.h"
+#include "CsvScanner.h"
+#include "GridBench.h"
+#include "ImportBench.h"
+#include "NumberParser.h"
+
+#include <QByteArrayList>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+
+#include <iostream>
+
+void print(QString msg)
+{
+    std::cout << msg.toStdString() << std::endl;
+}
+
+// Csv::separateLine() as it was before CsvScanner, used as baseline.
+QByteArrayList legacySeparateLine(const QByteArray &line, char separator,
+                                  bool combineSeparators)
+{
+    if (combineSeparators) {
+        QByteArray line2;
+        bool lastWasSep = false;
+        for (int i = 0; i < line.count(); i++) {
+            char c = line.at(i);
+            if (c == '\n') { break; } // Do not add newlines to output
+            bool isSep = (c == separator);
+            if (i == 0) {
+                // Skip leading separator
+                if (!isSep) {
+                    line2.append(c);
+                }
+            } else {
+                bool repeatedSep = isSep && lastWasSep;
+                if (!repeatedSep) {
+                    line2.append(c);
+                }
+            }
+            lastWasSep = isSep;
+        }
+        // Remove trailing separator
+        if (line2.endsWith(separator)) {
+            line2.remove(line2.count() - 1, 1);
+        }
+        return line2.split(separator);
+    } else {
+        return line.split(separator);
+    }
+}
+
+QByteArray generateLines(int rows, int cols, char separator, int padding)
+{
+    QRandomGenerator rand(1234);
+    QByteArray data;
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            if (col > 0) {
+                data.append(QByteArray(padding, separator));
+                data.append(separator);
+            }
+            data.append(QByteArray::number(rand.generateDouble() * 1000, 'f', 4));
+        }
+        data.append('\n');
+    }
+    return data;
+}
+
+void report(QString name, qint64 nsecs, qint64 bytes, int rows, qint64 fields)
+{
+    double secs = nsecs / 1e9;
+    print(QString("  %1 %2 MB/s  %3 ns/line  (%4 fields)")
+          .arg(name, -12)
+          .arg(bytes / secs / 1e6, 8, 'f', 1)
+          .arg(double(nsecs) / rows, 8, 'f', 1)
+          .arg(fields));
+}
+
+void benchSeparate(char separator, bool combine, int padding)
+{
+    const int rows = 200000;
+    const int cols = 20;
+    const int repeats = 5;
+
+    QByteArray data = generateLines(rows, cols, separator, padding);
+    QByteArrayList lines;
+    int start = 0;
+    while (start < data.count()) {
+        int end = data.indexOf('\n', start) + 1;
+        lines.append(data.mid(start, end - start));
+        start = end;
+    }
+
+    print(QString("Separate lines: %1 rows x %2 cols, separator '%3', "
+                  "combine %4, %5 MB")
+          .arg(rows).arg(cols)
+          .arg(separator == '\t' ? "\\t" : QString(separator))
+          .arg(combine ? "on" : "off")
+          .arg(data.count() / 1e6, 0, 'f', 1));
+
+    QElapsedTimer timer;
+
+    // Baseline
+    qint64 fields = 0;
+    timer.start();
+    for (int r = 0; r < repeats; r++) {
+        foreach (const QByteArray& line, lines) {
+            fields += legacySeparateLine(line, separator, combine).count();
+        }
+    }
+    report("legacy", timer.nsecsElapsed() / repeats, data.count(), rows,
+           fields / repeats);
+
+    // Scanner with each supported instruction set
+    CsvScanner::Isa best = CsvScanner::isa();
+    QList<CsvScanner::Isa> isas {CsvScanner::IsaScalar, CsvScanner::IsaSse2,
+                                 CsvScanner::IsaAvx2};
+    foreach (CsvScanner::Isa isa, isas) {
+        if (isa > best) { break; }
+        CsvScanner::setIsa(isa);
+
+        CsvScanner scanner(separator, combine);
+        QVector<ByteSpan> spans;
+        QVector<int> lineFieldIndex;
+        const char* end = data.constData() + data.count();
+
+        fields = 0;
+        timer.start();
+        for (int r = 0; r < repeats; r++) {
+            const char* pos = data.constData();
+            while (pos < end) {
+                pos = scanner.scan(pos, end, 256, spans, lineFieldIndex);
+                fields += spans.count();
+            }
+        }
+        report(CsvScanner::isaName(isa), timer.nsecsElapsed() / repeats,
+               data.count(), rows, fields / repeats);
+    }
+    CsvScanner::setIsa(best);
+}
+
+void benchConvert()
+{
+    const int count = 2000000;
+    QRandomGenerator rand(1234);
+
+    // Mix of short fixed point values and full precision values
+    QByteArrayList values;
+    for (int i = 0; i < count; i++) {
+        double d = (rand.generateDouble() - 0.5) * 2000;
+        if (i % 2) {
+            values.append(QByteArray::number(d, 'f', 4));
+        } else {
+            values.append(QByteArray::number(d, 'g', 17));
+        }
+    }
+
+    print(QString("Convert values: %1 values").arg(count));
+
+    QElapsedTimer timer;
+    double sum = 0;
+
+    timer.start();
+    foreach (const QByteArray& value, values) {
+        bool ok;
+        sum += value.toDouble(&ok);
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+    print(QString("  %1 %2 ns/value").arg("toDouble", -14)
+          .arg(double(nsecs) / count, 8, 'f', 1));
+
+    double sum2 = 0;
+    timer.start();
+    foreach (const QByteArray& value, values) {
+        double d = 0;
+        NumberParser::toDouble(value.constData(),
+                               value.constData() + value.size(), &d);
+        sum2 += d;
+    }
+    nsecs = timer.nsecsElapsed();
+    print(QString("  %1 %2 ns/value").arg("NumberParser", -14)
+          .arg(double(nsecs) / count, 8, 'f', 1));
+
+    if (sum != sum2) {
+        print("  Warning: results differ");
+    }
+}
+
+// Plot::findClosestCoord() as it was before ClosestKernel, used as baseline:
+// a virtual call per point to map it to pixels.
+class PixelMapper
+{
+public:
+    virtual ~PixelMapper() = default;
+    virtual QPoint coordToPixelPos(QPointF coord) = 0;
+};
+
+class LinearPixelMapper : public PixelMapper
+{
+public:
+    ClosestKernel::PixelMap map;
+    QPoint coordToPixelPos(QPointF coord) override
+    {
+        return QPoint(map.xx * coord.x() + map.dx,
+                      map.yy * coord.y() + map.dy);
+    }
+};
+
+void benchClosest()
+{
+    const int count = 1000000;
+    const int repeats = 20;
+    // Points per call, as for the points of a grid column
+    const int blockSize = 256;
+
+    QRandomGenerator rand(1234);
+    QVector<QPointF> coords(count);
+    for (int i = 0; i < count; i++) {
+        coords[i] = QPointF(rand.generateDouble() * 100,
+                            rand.generateDouble() * 100);
+    }
+    LinearPixelMapper mapper;
+    mapper.map.xx = 10;
+    mapper.map.dx = 20;
+    mapper.map.yy = -8;
+    mapper.map.dy = 820;
+    const ClosestKernel::PixelMap map = mapper.map;
+    QPoint mousePos(512, 384);
+
+    print(QString("Closest point: %1 points in blocks of %2")
+          .arg(count).arg(blockSize));
+
+    auto reportClosest = [count, repeats](QString name, qint64 nsecs,
+                                          int position)
+    {
+        print(QString("  %1 %2 ns/point  (closest %3)")
+              .arg(name, -12)
+              .arg(double(nsecs) / repeats / count, 8, 'f', 2)
+              .arg(position));
+    };
+
+    QElapsedTimer timer;
+
+    // Baseline
+    PixelMapper* virtualMapper = &mapper;
+    int position = -1;
+    timer.start();
+    for (int r = 0; r < repeats; r++) {
+        double closestDistSqr = 0;
+        position = -1;
+        for (int i = 0; i < count; i++) {
+            QPoint pixelPos = virtualMapper->coordToPixelPos(coords[i]);
+            double distSqr = qPow(mousePos.x() - pixelPos.x(), 2)
+                    + qPow(mousePos.y() - pixelPos.y(), 2);
+            if ((position < 0) || (distSqr < closestDistSqr)) {
+                closestDistSqr = distSqr;
+                position = i;
+            }
+        }
+    }
+    reportClosest("legacy", timer.nsecsElapsed(), position);
+
+    // Kernel with each supported instruction set
+    ClosestKernel::Isa best = ClosestKernel::isa();
+    foreach (ClosestKernel::Isa isa, QList<ClosestKernel::Isa>(
+                 {ClosestKernel::IsaScalar, ClosestKernel::IsaSse2})) {
+        if (isa > best) { break; }
+        ClosestKernel::setIsa(isa);
+
+        timer.start();
+        for (int r = 0; r < repeats; r++) {
+            double closestDistSqr = 0;
+            position = -1;
+            for (int from = 0; from < count; from += blockSize) {
+                ClosestKernel::Result result = ClosestKernel::closest(
+                            coords.constData() + from,
+                            qMin(blockSize, count - from),
+                            map, mousePos, ClosestXY);
+                if ((result.position >= 0) && ((position < 0)
+                        || (result.distSqr < closestDistSqr))) {
+                    closestDistSqr = result.distSqr;
+                    position = from + result.position;
+                }
+            }
+        }
+        reportClosest(ClosestKernel::isaName(isa), timer.nsecsElapsed(),
+                      position);
+    }
+    ClosestKernel::setIsa(best);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Benchmarks of the CSV import code. Without options, the field "
+                "separation, number conversion and closest point search "
+                "are measured.");
+    parser.addHelpOption();
+    parser.addOption({"import", "Run the import suite, printing a line of JSON "
+                      "per case. The baseline has --rows rows."});
+    parser.addOption({"import-case", "Run a single import case with the "
+                      "options below, printing a line of JSON."});
+    parser.addOption({"grid", "Run the closest point search cases instead."});
+    ImportBench::addCaseOptions(parser);
+    parser.process(a);
+
+    if (parser.isSet("grid")) {
+        GridBench::run();
+        return 0;
+    }
+
+    if (parser.isSet("import")) {
+        int rows = parser.isSet("rows") ? parser.value("rows").toInt() : 1000000;
+        return ImportBench::runSuite(a.applicationFilePath(), rows) ? 1 : 0;
+    }
+    if (parser.isSet("import-case")) {
+        return ImportBench::runCase(ImportBench::caseFromOptions(parser)) ? 0 : 1;
+    }
+
+    benchSeparate(',', false, 0);
+    benchSeparate('\t', false, 0);
+    benchSeparate(' ', true, 0);
+    benchSeparate(' ', true, 3);
+    benchConvert();
+    benchClosest();
+
+    return 0;
+}
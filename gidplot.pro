@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui svg
+QT       += core gui svg concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
@@ -21,6 +21,29 @@ TEMPLATE = app
 
 QMAKE_CXXFLAGS += -Wno-deprecated-declarations
 
+# Process memory info (ProcessMemory)
+win32: LIBS += -lpsapi
+
+# Compressed CSV files (CompressedFile). Each format is only supported if its
+# library is found.
+CONFIG += link_pkgconfig
+packagesExist(zlib) {
+    PKGCONFIG += zlib
+    DEFINES += GIDPLOT_ZLIB
+}
+packagesExist(libzstd) {
+    PKGCONFIG += libzstd
+    DEFINES += GIDPLOT_ZSTD
+}
+
+# Parquet and Arrow IPC files (ArrowSource), if Arrow C++ is found. Its
+# headers need C++17.
+packagesExist(arrow parquet) {
+    PKGCONFIG += arrow parquet
+    DEFINES += GIDPLOT_ARROW
+    CONFIG += c++17
+}
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -30,13 +53,25 @@ include(appicon/appicon.pri)
 include(src/QGeoView/QGeoView.pri)
 
 SOURCES += \
+    src/ArrowSource.cpp \
+    src/ClosestKernel.cpp \
+    src/Column.cpp \
+    src/CompressedFile.cpp \
+    src/CsvCache.cpp \
     src/CsvImportDialog.cpp \
+    src/CsvScanner.cpp \
+    src/CsvSource.cpp \
+    src/DecimatedCurve.cpp \
+    src/GridHash.cpp \
     src/LinkDialog.cpp \
     src/MapPlot.cpp \
     src/MarkerEditDialog.cpp \
+    src/NumberParser.cpp \
     src/PlotMarkerItem.cpp \
     src/PlotPropertiesDialog.cpp \
     src/PopoutTabWidget.cpp \
+    src/PyramidGraph.cpp \
+    src/ProcessMemory.cpp \
     src/ProgressDialog.cpp \
     src/QCustomPlot/GidQCustomPlot.cpp \
     src/QGVAnnotationItem.cpp \
@@ -45,6 +80,7 @@ SOURCES += \
     src/QGVLine.cpp \
     src/QGVMarker.cpp \
     src/Range.cpp \
+    src/Timestamp.cpp \
     src/aboutdialog.cpp \
     src/csv.cpp \
     src/graph.cpp \
@@ -60,13 +96,27 @@ SOURCES += \
     src/csvimporter.cpp
 
 HEADERS += \
+    src/ArrowSource.h \
+    src/ByteSpan.h \
+    src/ClosestKernel.h \
+    src/Column.h \
+    src/ColumnSource.h \
+    src/CompressedFile.h \
+    src/CsvCache.h \
     src/CsvImportDialog.h \
+    src/CsvScanner.h \
+    src/CsvSource.h \
+    src/DecimatedCurve.h \
+    src/GridHash.h \
     src/LinkDialog.h \
     src/MapPlot.h \
     src/MarkerEditDialog.h \
+    src/NumberParser.h \
     src/PlotMarkerItem.h \
     src/PlotPropertiesDialog.h \
     src/PopoutTabWidget.h \
+    src/PyramidGraph.h \
+    src/ProcessMemory.h \
     src/ProgressDialog.h \
     src/QCustomPlot/GidQCustomPlot.h \
     src/QGVAnnotationItem.h \
@@ -75,6 +125,7 @@ HEADERS += \
     src/QGVLine.h \
     src/QGVMarker.h \
     src/Range.h \
+    src/Timestamp.h \
     src/aboutdialog.h \
     src/csv.h \
     src/defer.h \
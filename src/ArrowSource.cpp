@@ -0,0 +1,576 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "ArrowSource.h"
+
+#include <QFile>
+#include <QHash>
+
+#include <limits>
+
+#ifdef GIDPLOT_ARROW
+    #include <arrow/api.h>
+    #include <arrow/io/file.h>
+    #include <arrow/ipc/reader.h>
+    #include <parquet/arrow/reader.h>
+    #include <parquet/arrow/schema.h>
+    #include <parquet/file_reader.h>
+    #include <parquet/metadata.h>
+#endif
+
+struct ArrowSource::Private
+{
+#ifdef GIDPLOT_ARROW
+    std::shared_ptr<arrow::io::RandomAccessFile> file;
+    std::shared_ptr<arrow::Schema> schema;
+
+    std::unique_ptr<parquet::arrow::FileReader> parquet;
+    // Parquet leaf column of each field, -1 for nested fields
+    QVector<int> parquetColumns;
+
+    // IPC file readers, each reading a single column
+    QHash<int, std::shared_ptr<arrow::ipc::RecordBatchFileReader>> ipcReaders;
+    std::shared_ptr<arrow::ipc::RecordBatchFileReader> ipcReader(int col,
+                                                                 QString& error);
+#endif
+};
+
+namespace {
+
+#ifdef GIDPLOT_ARROW
+
+QString statusString(const arrow::Status& status)
+{
+    return QString::fromStdString(status.ToString());
+}
+
+bool isStringType(const arrow::DataType& type)
+{
+    switch (type.id()) {
+    case arrow::Type::STRING:
+    case arrow::Type::LARGE_STRING:
+        return true;
+    case arrow::Type::DICTIONARY:
+        return isStringType(
+                    *static_cast<const arrow::DictionaryType&>(type).value_type());
+    default:
+        return false;
+    }
+}
+
+bool isSupportedType(const arrow::DataType& type)
+{
+    if (isStringType(type)) { return true; }
+    switch (type.id()) {
+    case arrow::Type::BOOL:
+    case arrow::Type::INT8:
+    case arrow::Type::UINT8:
+    case arrow::Type::INT16:
+    case arrow::Type::UINT16:
+    case arrow::Type::INT32:
+    case arrow::Type::UINT32:
+    case arrow::Type::INT64:
+    case arrow::Type::UINT64:
+    case arrow::Type::FLOAT:
+    case arrow::Type::DOUBLE:
+    case arrow::Type::DATE32:
+    case arrow::Type::DATE64:
+    case arrow::Type::TIMESTAMP:
+    case arrow::Type::TIME32:
+    case arrow::Type::TIME64:
+    case arrow::Type::DURATION:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isTimeType(const arrow::DataType& type)
+{
+    switch (type.id()) {
+    case arrow::Type::DATE32:
+    case arrow::Type::DATE64:
+    case arrow::Type::TIMESTAMP:
+    case arrow::Type::TIME32:
+    case arrow::Type::TIME64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Column type that holds all values of an Arrow type
+Column::Type storageType(const arrow::DataType& type)
+{
+    switch (type.id()) {
+    case arrow::Type::STRING:
+    case arrow::Type::LARGE_STRING:
+    case arrow::Type::DICTIONARY:
+        // Category codes, widened as categories are added
+    case arrow::Type::BOOL:
+        return Column::TypeBool;
+    case arrow::Type::INT8:
+        return Column::TypeInt8;
+    case arrow::Type::UINT8:
+    case arrow::Type::INT16:
+        return Column::TypeInt16;
+    case arrow::Type::UINT16:
+    case arrow::Type::INT32:
+        return Column::TypeInt32;
+    case arrow::Type::FLOAT:
+        return Column::TypeFloat;
+    default:
+        return Column::TypeDouble;
+    }
+}
+
+double secondsPerUnit(arrow::TimeUnit::type unit)
+{
+    switch (unit) {
+    case arrow::TimeUnit::SECOND: return 1;
+    case arrow::TimeUnit::MILLI: return 1e-3;
+    case arrow::TimeUnit::MICRO: return 1e-6;
+    case arrow::TimeUnit::NANO: return 1e-9;
+    }
+    return 1;
+}
+
+template<typename ArrayType>
+void appendValues(const arrow::Array& array, double scale,
+                  QVector<double>& values, QVector<ColumnSource::Error>& errors)
+{
+    const ArrayType& a = static_cast<const ArrayType&>(array);
+    int offset = values.count();
+    bool hasNulls = (a.null_count() > 0);
+    for (int64_t i = 0; i < a.length(); i++) {
+        if (hasNulls && a.IsNull(i)) {
+            ColumnSource::Error error;
+            error.row = offset + int(i);
+            errors.append(error);
+            values.append(0);
+        } else {
+            values.append(double(a.Value(i)) * scale);
+        }
+    }
+}
+
+// Texts of a string array, as category entries of the errors
+template<typename ArrayType>
+void appendTexts(const arrow::Array& array, QVector<double>& values,
+                 QVector<ColumnSource::Error>& errors)
+{
+    const ArrayType& a = static_cast<const ArrayType&>(array);
+    int offset = values.count();
+    for (int64_t i = 0; i < a.length(); i++) {
+        ColumnSource::Error error;
+        error.row = offset + int(i);
+        if (!a.IsNull(i)) {
+            std::string text = a.GetString(i);
+            error.type = ColumnSource::Error::Category;
+            error.text = QByteArray(text.data(), int(text.size()));
+        }
+        errors.append(error);
+        values.append(0);
+    }
+}
+
+template<typename ArrayType>
+void appendDictionaryTexts(const arrow::DictionaryArray& array,
+                           QVector<double>& values,
+                           QVector<ColumnSource::Error>& errors)
+{
+    // Dictionary texts converted once, shared by the rows
+    const ArrayType& dictionary = static_cast<const ArrayType&>(*array.dictionary());
+    QVector<QByteArray> texts;
+    for (int64_t i = 0; i < dictionary.length(); i++) {
+        std::string text = dictionary.GetString(i);
+        texts.append(QByteArray(text.data(), int(text.size())));
+    }
+    int offset = values.count();
+    for (int64_t i = 0; i < array.length(); i++) {
+        ColumnSource::Error error;
+        error.row = offset + int(i);
+        if (!array.IsNull(i)) {
+            error.type = ColumnSource::Error::Category;
+            error.text = texts.value(int(array.GetValueIndex(i)));
+        }
+        errors.append(error);
+        values.append(0);
+    }
+}
+
+void appendArray(const arrow::Array& array, QVector<double>& values,
+                 QVector<ColumnSource::Error>& errors)
+{
+    const arrow::DataType& type = *array.type();
+    switch (type.id()) {
+    case arrow::Type::STRING:
+        appendTexts<arrow::StringArray>(array, values, errors);
+        break;
+    case arrow::Type::LARGE_STRING:
+        appendTexts<arrow::LargeStringArray>(array, values, errors);
+        break;
+    case arrow::Type::DICTIONARY:
+    {
+        const arrow::DictionaryArray& a =
+                static_cast<const arrow::DictionaryArray&>(array);
+        if (a.dictionary()->type_id() == arrow::Type::LARGE_STRING) {
+            appendDictionaryTexts<arrow::LargeStringArray>(a, values, errors);
+        } else {
+            appendDictionaryTexts<arrow::StringArray>(a, values, errors);
+        }
+        break;
+    }
+    case arrow::Type::BOOL:
+        appendValues<arrow::BooleanArray>(array, 1, values, errors);
+        break;
+    case arrow::Type::INT8:
+        appendValues<arrow::Int8Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::UINT8:
+        appendValues<arrow::UInt8Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::INT16:
+        appendValues<arrow::Int16Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::UINT16:
+        appendValues<arrow::UInt16Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::INT32:
+        appendValues<arrow::Int32Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::UINT32:
+        appendValues<arrow::UInt32Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::INT64:
+        appendValues<arrow::Int64Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::UINT64:
+        appendValues<arrow::UInt64Array>(array, 1, values, errors);
+        break;
+    case arrow::Type::FLOAT:
+        appendValues<arrow::FloatArray>(array, 1, values, errors);
+        break;
+    case arrow::Type::DOUBLE:
+        appendValues<arrow::DoubleArray>(array, 1, values, errors);
+        break;
+    case arrow::Type::DATE32:
+        // Days since the epoch
+        appendValues<arrow::Date32Array>(array, 86400, values, errors);
+        break;
+    case arrow::Type::DATE64:
+        // Milliseconds since the epoch
+        appendValues<arrow::Date64Array>(array, 1e-3, values, errors);
+        break;
+    case arrow::Type::TIMESTAMP:
+        appendValues<arrow::TimestampArray>(
+                    array,
+                    secondsPerUnit(static_cast<const arrow::TimestampType&>(type).unit()),
+                    values, errors);
+        break;
+    case arrow::Type::TIME32:
+        appendValues<arrow::Time32Array>(
+                    array,
+                    secondsPerUnit(static_cast<const arrow::Time32Type&>(type).unit()),
+                    values, errors);
+        break;
+    case arrow::Type::TIME64:
+        appendValues<arrow::Time64Array>(
+                    array,
+                    secondsPerUnit(static_cast<const arrow::Time64Type&>(type).unit()),
+                    values, errors);
+        break;
+    case arrow::Type::DURATION:
+        appendValues<arrow::DurationArray>(
+                    array,
+                    secondsPerUnit(static_cast<const arrow::DurationType&>(type).unit()),
+                    values, errors);
+        break;
+    default:
+        // Not supported, left zero
+        values.insert(values.count(), int(array.length()), 0);
+        break;
+    }
+}
+
+#endif // GIDPLOT_ARROW
+
+} // namespace
+
+ArrowSource::ArrowSource() : d(new Private())
+{
+
+}
+
+ArrowSource::~ArrowSource()
+{
+
+}
+
+ArrowSource::Format ArrowSource::format(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) { return NoFormat; }
+    QByteArray magic = file.read(6);
+    if (magic.startsWith("PAR1")) {
+        return Parquet;
+    } else if (magic == "ARROW1") {
+        return ArrowIpc;
+    }
+    return NoFormat;
+}
+
+QString ArrowSource::formatName(Format format)
+{
+    switch (format) {
+    case Parquet:
+        return "Parquet";
+    case ArrowIpc:
+        return "Arrow IPC";
+    default:
+        return "";
+    }
+}
+
+bool ArrowSource::isSupported()
+{
+#ifdef GIDPLOT_ARROW
+    return true;
+#else
+    return false;
+#endif
+}
+
+QSharedPointer<ArrowSource> ArrowSource::open(QString filename, QString &error)
+{
+#ifdef GIDPLOT_ARROW
+    QSharedPointer<ArrowSource> source(new ArrowSource());
+    source->mFormat = format(filename);
+    Private& d = *source->d;
+
+    // Memory-mapped, so reading a column only touches its own pages
+    arrow::Result<std::shared_ptr<arrow::io::MemoryMappedFile>> file =
+            arrow::io::MemoryMappedFile::Open(filename.toStdString(),
+                                              arrow::io::FileMode::READ);
+    if (!file.ok()) {
+        error = statusString(file.status());
+        return QSharedPointer<ArrowSource>();
+    }
+    d.file = *file;
+
+    QVector<qint64> blockRows;
+    if (source->mFormat == Parquet) {
+
+        parquet::arrow::FileReaderBuilder builder;
+        arrow::Status status = builder.Open(d.file);
+        if (status.ok()) {
+            status = builder.Build(&d.parquet);
+        }
+        if (status.ok()) {
+            status = d.parquet->GetSchema(&d.schema);
+        }
+        if (!status.ok()) {
+            error = statusString(status);
+            return QSharedPointer<ArrowSource>();
+        }
+
+        std::shared_ptr<parquet::FileMetaData> metadata =
+                d.parquet->parquet_reader()->metadata();
+        for (int i = 0; i < metadata->num_row_groups(); i++) {
+            blockRows.append(metadata->RowGroup(i)->num_rows());
+        }
+        const parquet::arrow::SchemaManifest& manifest = d.parquet->manifest();
+        for (int i = 0; i < d.schema->num_fields(); i++) {
+            const parquet::arrow::SchemaField& field = manifest.schema_fields[i];
+            d.parquetColumns.append(field.is_leaf() ? field.column_index : -1);
+        }
+
+    } else if (source->mFormat == ArrowIpc) {
+
+        std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader = d.ipcReader(-1, error);
+        if (!reader) { return QSharedPointer<ArrowSource>(); }
+        d.schema = reader->schema();
+
+        // Row counts are only stored in the batches. Read them projected to
+        // the first column, which without compression only reads metadata.
+        if (d.schema->num_fields() > 0) {
+            reader = d.ipcReader(0, error);
+            if (!reader) { return QSharedPointer<ArrowSource>(); }
+        }
+        for (int i = 0; i < reader->num_record_batches(); i++) {
+            arrow::Result<std::shared_ptr<arrow::RecordBatch>> batch =
+                    reader->ReadRecordBatch(i);
+            if (!batch.ok()) {
+                error = statusString(batch.status());
+                return QSharedPointer<ArrowSource>();
+            }
+            blockRows.append((*batch)->num_rows());
+        }
+
+    } else {
+        error = "File is not a Parquet or Arrow IPC file";
+        return QSharedPointer<ArrowSource>();
+    }
+
+    qint64 rows = 0;
+    foreach (qint64 n, blockRows) {
+        source->mBlockStarts.append(int(rows));
+        rows += n;
+        // Rows are indexed with int
+        if (rows > std::numeric_limits<int>::max()) {
+            error = "Too many rows";
+            return QSharedPointer<ArrowSource>();
+        }
+    }
+    source->mBlockStarts.append(int(rows));
+
+    for (int i = 0; i < d.schema->num_fields(); i++) {
+        const arrow::Field& field = *d.schema->field(i);
+        bool supported = isSupportedType(*field.type());
+        if (source->mFormat == Parquet) {
+            supported = supported && (d.parquetColumns[i] >= 0);
+        }
+        QString heading = QString::fromStdString(field.name());
+        if (!supported) {
+            heading += QString(" (unsupported type %1)")
+                    .arg(QString::fromStdString(field.type()->ToString()));
+        }
+        source->mHeadings.append(heading);
+        source->mTypes.append(storageType(*field.type()));
+        source->mTimeColumns.append(isTimeType(*field.type()));
+        source->mCategoryColumns.append(isStringType(*field.type()));
+        source->mSupported.append(supported);
+    }
+
+    return source;
+#else
+    Q_UNUSED(filename);
+    error = "Opening Parquet and Arrow files is not supported in this build";
+    return QSharedPointer<ArrowSource>();
+#endif
+}
+
+int ArrowSource::rowCount() const
+{
+    return mBlockStarts.last();
+}
+
+int ArrowSource::columnCount() const
+{
+    return mHeadings.count();
+}
+
+QStringList ArrowSource::headings() const
+{
+    return mHeadings;
+}
+
+Column::Type ArrowSource::columnType(int col) const
+{
+    return mTypes.value(col, Column::TypeDouble);
+}
+
+bool ArrowSource::isTimeColumn(int col) const
+{
+    return mTimeColumns.value(col);
+}
+
+bool ArrowSource::isCategoryColumn(int col) const
+{
+    return mCategoryColumns.value(col);
+}
+
+int ArrowSource::blockCount() const
+{
+    return mBlockStarts.count() - 1;
+}
+
+int ArrowSource::blockStart(int block) const
+{
+    return mBlockStarts.value(block, rowCount());
+}
+
+bool ArrowSource::readBlock(int col, int block, QVector<double> &values,
+                            QVector<Error> &errors, QString &error)
+{
+    if (!mSupported.value(col)) {
+        values.fill(0, blockStart(block + 1) - blockStart(block));
+        return true;
+    }
+
+#ifdef GIDPLOT_ARROW
+    if (mFormat == Parquet) {
+
+        std::shared_ptr<arrow::Table> table;
+        arrow::Status status = d->parquet->ReadRowGroup(
+                    block, {d->parquetColumns[col]}, &table);
+        if (!status.ok()) {
+            error = statusString(status);
+            return false;
+        }
+        for (const std::shared_ptr<arrow::Array>& chunk : table->column(0)->chunks()) {
+            appendArray(*chunk, values, errors);
+        }
+
+    } else {
+
+        std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader =
+                d->ipcReader(col, error);
+        if (!reader) { return false; }
+        arrow::Result<std::shared_ptr<arrow::RecordBatch>> batch =
+                reader->ReadRecordBatch(block);
+        if (!batch.ok()) {
+            error = statusString(batch.status());
+            return false;
+        }
+        appendArray(*(*batch)->column(0), values, errors);
+    }
+    return true;
+#else
+    Q_UNUSED(block);
+    Q_UNUSED(values);
+    Q_UNUSED(errors);
+    error = "Not supported in this build";
+    return false;
+#endif
+}
+
+#ifdef GIDPLOT_ARROW
+std::shared_ptr<arrow::ipc::RecordBatchFileReader> ArrowSource::Private::ipcReader(
+        int col, QString& error)
+{
+    // Opening only reads the footer
+    if (ipcReaders.contains(col)) { return ipcReaders.value(col); }
+
+    arrow::ipc::IpcReadOptions options = arrow::ipc::IpcReadOptions::Defaults();
+    if (col >= 0) {
+        options.included_fields = {col};
+    }
+    arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> reader =
+            arrow::ipc::RecordBatchFileReader::Open(file, options);
+    if (!reader.ok()) {
+        error = statusString(reader.status());
+        return nullptr;
+    }
+    ipcReaders.insert(col, *reader);
+    return *reader;
+}
+#endif
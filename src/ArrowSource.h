@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef ARROWSOURCE_H
+#define ARROWSOURCE_H
+
+#include "ColumnSource.h"
+
+#include <QScopedPointer>
+
+/* ArrowSource reads columns of Parquet and Arrow IPC (Feather v2) files on
+ * demand, using the Apache Arrow C++ libraries.
+ *
+ * Blocks are Parquet row groups or Arrow record batches. Only the requested
+ * column is read from them (projection), so the rest of the file is never
+ * touched. Numeric, boolean, temporal and string columns are supported.
+ * Temporal values are converted to seconds (dates to seconds since the
+ * epoch). String columns, also dictionary encoded ones, are category columns
+ * (see Matrix::isCategoryColumn()). Columns of other types, e.g. lists, are
+ * all zero.
+ *
+ * Only available if Arrow was found when building (see gidplot.pro). */
+
+class ArrowSource : public ColumnSource
+{
+public:
+    enum Format { NoFormat, Parquet, ArrowIpc };
+    // Format of a file, from the magic bytes at its start
+    static Format format(QString filename);
+    static QString formatName(Format format);
+    // Whether this build can read the formats
+    static bool isSupported();
+
+    // Returns null with error set if the file can't be read
+    static QSharedPointer<ArrowSource> open(QString filename, QString& error);
+    ~ArrowSource();
+
+    int rowCount() const override;
+    int columnCount() const override;
+    QStringList headings() const override;
+    Column::Type columnType(int col) const override;
+    bool isTimeColumn(int col) const override;
+    bool isCategoryColumn(int col) const override;
+    int blockCount() const override;
+    int blockStart(int block) const override;
+    bool readBlock(int col, int block, QVector<double>& values,
+                   QVector<Error>& errors, QString& error) override;
+
+private:
+    ArrowSource();
+
+    Format mFormat = NoFormat;
+    QStringList mHeadings;
+    QVector<Column::Type> mTypes;
+    // Date, time and timestamp columns
+    QVector<bool> mTimeColumns;
+    // String columns
+    QVector<bool> mCategoryColumns;
+    // Whether a column's type can be converted to numbers
+    QVector<bool> mSupported;
+    // Including rowCount() at the end
+    QVector<int> mBlockStarts;
+
+    // Arrow objects, kept out of this header
+    struct Private;
+    QScopedPointer<Private> d;
+};
+
+#endif // ARROWSOURCE_H
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef BYTESPAN_H
+#define BYTESPAN_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <cstring>
+
+/* ByteSpan is a non-owning view of a range of bytes, typically a field of a
+ * line inside a memory-mapped CSV file. It is only valid as long as the memory
+ * it points to is. Use toByteArray() or toString() to make an owned copy. */
+
+struct ByteSpan
+{
+    ByteSpan() {}
+    ByteSpan(const char* data, int size) : data(data), size(size) {}
+
+    const char* data = nullptr;
+    int size = 0;
+    // The bytes are from a quoted CSV field and have doubled quotes ("")
+    // standing for one quote. Undone by toByteArray() and toString().
+    bool escapedQuotes = false;
+
+    bool isEmpty() const { return size == 0; }
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+    QByteArray toByteArray() const
+    {
+        QByteArray ret(data, size);
+        if (escapedQuotes) { ret.replace("\"\"", "\""); }
+        return ret;
+    }
+    QString toString() const { return QString::fromUtf8(toByteArray()); }
+};
+
+// Compare and hash the bytes, e.g. to look up category texts
+inline bool operator==(ByteSpan a, ByteSpan b)
+{
+    return (a.size == b.size) && (a.escapedQuotes == b.escapedQuotes)
+            && ((a.size == 0) || (memcmp(a.data, b.data, a.size) == 0));
+}
+
+inline uint qHash(ByteSpan span, uint seed = 0)
+{
+    return qHashBits(span.data, span.size, seed);
+}
+
+#endif // BYTESPAN_H
@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "ClosestKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) \
+        || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define CLOSESTKERNEL_X86
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+typedef ClosestKernel::Result (*ClosestFunc)(const QPointF* coords, int count,
+                                             const ClosestKernel::PixelMap& map,
+                                             QPointF pixelPos);
+
+template<bool withY>
+ClosestKernel::Result closestScalar(const QPointF* coords, int count,
+                                    const ClosestKernel::PixelMap& map,
+                                    QPointF pixelPos)
+{
+    ClosestKernel::Result r;
+    const double mx = pixelPos.x();
+    const double my = pixelPos.y();
+    for (int i = 0; i < count; i++) {
+        double x = coords[i].x();
+        double y = coords[i].y();
+        double dist;
+        if (withY) {
+            double dx = mx - (map.xx * x + map.xy * y + map.dx);
+            double dy = my - (map.yx * x + map.yy * y + map.dy);
+            dist = dx * dx + dy * dy;
+        } else {
+            double dx = mx - (map.xx * x + map.dx);
+            dist = dx * dx;
+        }
+        // False for NaN
+        if (dist < r.distSqr) {
+            r.distSqr = dist;
+            r.position = i;
+        }
+    }
+    return r;
+}
+
+#ifdef CLOSESTKERNEL_X86
+
+// QPointF is loaded as a pair of doubles
+static_assert(sizeof(QPointF) == 2 * sizeof(double),
+              "QPointF is expected to hold two doubles");
+
+template<bool withY>
+ClosestKernel::Result closestSse2(const QPointF* coords, int count,
+                                  const ClosestKernel::PixelMap& map,
+                                  QPointF pixelPos)
+{
+    const __m128d vxx = _mm_set1_pd(map.xx);
+    const __m128d vxy = _mm_set1_pd(map.xy);
+    const __m128d vdx = _mm_set1_pd(map.dx);
+    const __m128d vyx = _mm_set1_pd(map.yx);
+    const __m128d vyy = _mm_set1_pd(map.yy);
+    const __m128d vdy = _mm_set1_pd(map.dy);
+    const __m128d vmx = _mm_set1_pd(pixelPos.x());
+    const __m128d vmy = _mm_set1_pd(pixelPos.y());
+    const __m128d two = _mm_set1_pd(2);
+
+    // Per lane minimum and its position (as a double, exact up to 2^53)
+    __m128d best = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    __m128d bestPos = _mm_set1_pd(-1);
+    __m128d pos = _mm_set_pd(1, 0);
+
+    const double* data = reinterpret_cast<const double*>(coords);
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d a = _mm_loadu_pd(data + 2 * i);     // x0 y0
+        __m128d b = _mm_loadu_pd(data + 2 * i + 2); // x1 y1
+        __m128d x = _mm_unpacklo_pd(a, b);
+        __m128d dist;
+        if (withY) {
+            __m128d y = _mm_unpackhi_pd(a, b);
+            __m128d px = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vxx, x),
+                                               _mm_mul_pd(vxy, y)), vdx);
+            __m128d py = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vyx, x),
+                                               _mm_mul_pd(vyy, y)), vdy);
+            __m128d dx = _mm_sub_pd(vmx, px);
+            __m128d dy = _mm_sub_pd(vmy, py);
+            dist = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        } else {
+            __m128d px = _mm_add_pd(_mm_mul_pd(vxx, x), vdx);
+            __m128d dx = _mm_sub_pd(vmx, px);
+            dist = _mm_mul_pd(dx, dx);
+        }
+        // All bits set in lanes that are closer (false for NaN)
+        __m128d closer = _mm_cmplt_pd(dist, best);
+        best = _mm_or_pd(_mm_and_pd(closer, dist), _mm_andnot_pd(closer, best));
+        bestPos = _mm_or_pd(_mm_and_pd(closer, pos), _mm_andnot_pd(closer, bestPos));
+        pos = _mm_add_pd(pos, two);
+    }
+
+    double laneBest[2];
+    double lanePos[2];
+    _mm_storeu_pd(laneBest, best);
+    _mm_storeu_pd(lanePos, bestPos);
+
+    ClosestKernel::Result r;
+    for (int lane = 0; lane < 2; lane++) {
+        if (lanePos[lane] < 0) { continue; }
+        bool earlier = (r.position < 0) || (lanePos[lane] < r.position);
+        if ((laneBest[lane] < r.distSqr)
+                || ((laneBest[lane] == r.distSqr) && earlier)) {
+            r.distSqr = laneBest[lane];
+            r.position = lanePos[lane];
+        }
+    }
+
+    // Remaining point after the pairs
+    if (i < count) {
+        ClosestKernel::Result tail = closestScalar<withY>(coords + i, count - i,
+                                                       map, pixelPos);
+        if (tail.distSqr < r.distSqr) {
+            r.distSqr = tail.distSqr;
+            r.position = i + tail.position;
+        }
+    }
+
+    return r;
+}
+
+#endif // CLOSESTKERNEL_X86
+
+ClosestKernel::Isa bestIsa()
+{
+#ifdef CLOSESTKERNEL_X86
+    return ClosestKernel::IsaSse2;
+#else
+    return ClosestKernel::IsaScalar;
+#endif
+}
+
+ClosestKernel::Isa& currentIsa()
+{
+    static ClosestKernel::Isa isa = bestIsa();
+    return isa;
+}
+
+} // namespace
+
+ClosestKernel::Result ClosestKernel::closest(const QPointF* coords, int count,
+                                             const PixelMap& map,
+                                             QPointF pixelPos,
+                                             ClosestOption option)
+{
+    bool xy = (option == ClosestXY);
+    ClosestFunc func = xy ? closestScalar<true> : closestScalar<false>;
+#ifdef CLOSESTKERNEL_X86
+    if (currentIsa() == IsaSse2) {
+        func = xy ? closestSse2<true> : closestSse2<false>;
+    }
+#endif
+    return func(coords, count, map, pixelPos);
+}
+
+ClosestKernel::Isa ClosestKernel::isa()
+{
+    return currentIsa();
+}
+
+QString ClosestKernel::isaName(Isa isa)
+{
+    switch (isa) {
+    case IsaScalar: return "Scalar";
+    case IsaSse2: return "SSE2";
+    }
+    return QString();
+}
+
+void ClosestKernel::setIsa(Isa isa)
+{
+    currentIsa() = qMin(isa, bestIsa());
+}
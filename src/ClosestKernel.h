@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef CLOSESTKERNEL_H
+#define CLOSESTKERNEL_H
+
+#include "GridHash.h"
+
+#include <QPointF>
+#include <QString>
+
+#include <limits>
+
+/* ClosestKernel finds the point closest to a pixel position among a block of
+ * coordinates, such as the points of a grid hash column. Coordinates are
+ * mapped to pixels with an affine map worked out once per lookup instead of
+ * calling the plot's mapping for every point, and the squared distances and
+ * running minimum are computed two points at a time with SSE2 where
+ * available, with a scalar fallback.
+ *
+ * For ClosestXOnly only the x pixel is used, which is taken to depend on x
+ * only (map.xy == 0). Points with NaN coordinates are never closest. Of
+ * points at the same distance, the first is returned. */
+
+class ClosestKernel
+{
+public:
+    // Coordinate to pixel mapping:
+    //   pixel x = xx * x + xy * y + dx
+    //   pixel y = yx * x + yy * y + dy
+    struct PixelMap
+    {
+        double xx = 1;
+        double xy = 0;
+        double dx = 0;
+        double yx = 0;
+        double yy = 1;
+        double dy = 0;
+    };
+
+    struct Result
+    {
+        // Position in the coordinates, or -1 if none
+        int position = -1;
+        double distSqr = std::numeric_limits<double>::infinity();
+    };
+
+    static Result closest(const QPointF* coords, int count,
+                          const PixelMap& map, QPointF pixelPos,
+                          ClosestOption option);
+
+    enum Isa { IsaScalar, IsaSse2 };
+    static Isa isa();
+    static QString isaName(Isa isa);
+    // Override the automatically detected instruction set, e.g. for
+    // benchmarking. Falls back to a supported one if not available.
+    static void setIsa(Isa isa);
+};
+
+#endif // CLOSESTKERNEL_H
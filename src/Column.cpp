@@ -0,0 +1,416 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "Column.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+
+template<typename From, typename To>
+void convert(const From* src, To* dst, int count, int srcStride = 1)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = To(src[qint64(i) * srcStride]);
+    }
+}
+
+} // namespace
+
+Column::Column()
+{
+
+}
+
+Column::Column(Type type) : mType(type)
+{
+
+}
+
+QString Column::typeName(Type type)
+{
+    switch (type) {
+    case TypeBool: return "bool";
+    case TypeInt8: return "int8";
+    case TypeInt16: return "int16";
+    case TypeInt32: return "int32";
+    case TypeFloat: return "float";
+    case TypeDouble: return "double";
+    }
+    return "";
+}
+
+int Column::typeSize(Type type)
+{
+    switch (type) {
+    case TypeBool: return sizeof(quint8);
+    case TypeInt8: return sizeof(qint8);
+    case TypeInt16: return sizeof(qint16);
+    case TypeInt32: return sizeof(qint32);
+    case TypeFloat: return sizeof(float);
+    case TypeDouble: return sizeof(double);
+    }
+    return sizeof(double);
+}
+
+bool Column::fits(Type type, double value)
+{
+    switch (type) {
+    case TypeBool:
+        return (value == 0) || (value == 1);
+    case TypeInt8:
+        return (value >= -128) && (value <= 127) && (value == double(qint8(value)));
+    case TypeInt16:
+        return (value >= -32768) && (value <= 32767)
+                && (value == double(qint16(value)));
+    case TypeInt32:
+        return (value >= -2147483648.0) && (value <= 2147483647.0)
+                && (value == double(qint32(value)));
+    case TypeFloat:
+        // Also false for NaN
+        return (std::fabs(value) <= FLT_MAX) && (double(float(value)) == value);
+    case TypeDouble:
+        return true;
+    }
+    return false;
+}
+
+Column::Type Column::typeFor(double value)
+{
+    for (int t = TypeBool; t < TypeDouble; t++) {
+        if (fits(Type(t), value)) { return Type(t); }
+    }
+    return TypeDouble;
+}
+
+Column::Type Column::commonType(Type a, Type b)
+{
+    Type hi = qMax(a, b);
+    Type lo = qMin(a, b);
+    if (hi <= TypeInt32) {
+        // Both integer types
+        return hi;
+    }
+    if (hi == TypeFloat) {
+        // Float holds integers up to 2^24 exactly
+        return (lo <= TypeInt16) ? TypeFloat : TypeDouble;
+    }
+    return TypeDouble;
+}
+
+qint64 Column::memoryUsage() const
+{
+    qint64 ret = 0;
+    foreach (const QByteArray& block, mBlocks) {
+        ret += block.capacity();
+    }
+    return ret;
+}
+
+double Column::at(int index) const
+{
+    const char* p = valuePtr(index);
+    switch (mType) {
+    case TypeBool: return *reinterpret_cast<const quint8*>(p);
+    case TypeInt8: return *reinterpret_cast<const qint8*>(p);
+    case TypeInt16: return *reinterpret_cast<const qint16*>(p);
+    case TypeInt32: return *reinterpret_cast<const qint32*>(p);
+    case TypeFloat: return *reinterpret_cast<const float*>(p);
+    case TypeDouble: return *reinterpret_cast<const double*>(p);
+    }
+    return 0;
+}
+
+QVector<double> Column::toDoubles(int startIndex, int length) const
+{
+    return view(startIndex, length).toDoubles();
+}
+
+ColumnView Column::view(int startIndex, int length) const
+{
+    Q_ASSERT(isContiguous());
+    const char* data = mBlocks.isEmpty() ? nullptr : mBlocks[0].constData();
+    return ColumnView(data, mType, mCount).mid(startIndex, length);
+}
+
+Column Column::fromData(Type type, int count, const QByteArray& data)
+{
+    Q_ASSERT(data.size() >= count * typeSize(type));
+    Column column;
+    column.mType = type;
+    column.mCount = count;
+    if (count > 0) {
+        column.mBlocks.append(data);
+        column.mFirstBlockCapacity = count;
+    }
+    return column;
+}
+
+void Column::append(double value)
+{
+    if (!fits(mType, value)) {
+        widen(commonType(mType, typeFor(value)));
+    }
+    if (mCount == capacity()) {
+        addBlock();
+    }
+    store(mCount, value);
+    mCount++;
+}
+
+void Column::append(const double *values, int count)
+{
+    // Find the type for the whole block first so it is widened at most once
+    Type type = mType;
+    for (int i = 0; i < count; i++) {
+        if (!fits(type, values[i])) {
+            type = commonType(type, typeFor(values[i]));
+            if (type == TypeDouble) { break; }
+        }
+    }
+    if (type != mType) {
+        widen(type);
+    }
+
+    int done = 0;
+    while (done < count) {
+        if (mCount == capacity()) {
+            addBlock();
+        }
+        // As many as fit in the current block
+        int n = qMin(count - done, blockSpace(mCount));
+        const double* src = values + done;
+        char* dst = valuePtr(mCount);
+        switch (mType) {
+        case TypeBool: convert(src, reinterpret_cast<quint8*>(dst), n); break;
+        case TypeInt8: convert(src, reinterpret_cast<qint8*>(dst), n); break;
+        case TypeInt16: convert(src, reinterpret_cast<qint16*>(dst), n); break;
+        case TypeInt32: convert(src, reinterpret_cast<qint32*>(dst), n); break;
+        case TypeFloat: convert(src, reinterpret_cast<float*>(dst), n); break;
+        case TypeDouble: memcpy(dst, src, n * sizeof(double)); break;
+        }
+        mCount += n;
+        done += n;
+    }
+}
+
+void Column::set(int index, double value)
+{
+    if (!fits(mType, value)) {
+        widen(commonType(mType, typeFor(value)));
+    }
+    store(index, value);
+}
+
+void Column::resize(int count)
+{
+    while (capacity() < count) {
+        addBlock();
+    }
+    // Zero is zero in all types
+    int size = typeSize(mType);
+    while (mCount < count) {
+        int n = qMin(count - mCount, blockSpace(mCount));
+        memset(valuePtr(mCount), 0, qint64(n) * size);
+        mCount += n;
+    }
+    mCount = count;
+}
+
+void Column::reserve(int count)
+{
+    if (count <= capacity()) { return; }
+
+    if (mBlocks.isEmpty()) {
+        mBlocks.append(QByteArray());
+    } else if (mBlocks.count() > 1) {
+        return;
+    }
+    // Growing a large allocation can often be done in place
+    mBlocks[0].resize(count * typeSize(mType));
+    mFirstBlockCapacity = count;
+}
+
+void Column::consolidate()
+{
+    int size = typeSize(mType);
+
+    if (mBlocks.count() > 1) {
+        QByteArray& first = mBlocks[0];
+        first.resize(mCount * size);
+        int index = mFirstBlockCapacity;
+        for (int i = 1; (i < mBlocks.count()) && (index < mCount); i++) {
+            int n = qMin(blockCapacity(), mCount - index);
+            memcpy(first.data() + qint64(index) * size,
+                   mBlocks[i].constData(), qint64(n) * size);
+            // Free each block once copied to keep the peak down
+            mBlocks[i] = QByteArray();
+            index += n;
+        }
+        mBlocks.resize(1);
+    }
+
+    if (mBlocks.count() == 1) {
+        const QByteArray& block = mBlocks.at(0);
+        if ((block.size() == mCount * size) && (block.capacity() <= block.size())) {
+            // Already exact. Also leaves data from fromData() uncopied.
+            mFirstBlockCapacity = mCount;
+            return;
+        }
+        mBlocks[0].resize(mCount * size);
+        mBlocks[0].squeeze();
+        mFirstBlockCapacity = mCount;
+    }
+}
+
+int Column::capacity() const
+{
+    if (mBlocks.isEmpty()) { return 0; }
+    return mFirstBlockCapacity + (mBlocks.count() - 1) * blockCapacity();
+}
+
+void Column::addBlock()
+{
+    int blockSize = blockCapacity();
+    if (mBlocks.isEmpty()) {
+        mFirstBlockCapacity = blockSize;
+    }
+    QByteArray block;
+    block.resize(blockSize * typeSize(mType));
+    mBlocks.append(block);
+}
+
+int Column::blockSpace(int index) const
+{
+    if (index < mFirstBlockCapacity) {
+        return mFirstBlockCapacity - index;
+    }
+    return blockCapacity() - (index - mFirstBlockCapacity) % blockCapacity();
+}
+
+char *Column::valuePtr(int index)
+{
+    int size = typeSize(mType);
+    if (index < mFirstBlockCapacity) {
+        return mBlocks[0].data() + qint64(index) * size;
+    }
+    int i = index - mFirstBlockCapacity;
+    return mBlocks[1 + i / blockCapacity()].data() + (i % blockCapacity()) * size;
+}
+
+const char *Column::valuePtr(int index) const
+{
+    int size = typeSize(mType);
+    if (index < mFirstBlockCapacity) {
+        return mBlocks[0].constData() + qint64(index) * size;
+    }
+    int i = index - mFirstBlockCapacity;
+    return mBlocks[1 + i / blockCapacity()].constData() + (i % blockCapacity()) * size;
+}
+
+void Column::widen(Type type)
+{
+    Column widened;
+    widened.mType = type;
+    // Keep the reserved capacity in number of values, in one block
+    widened.reserve(qMax(capacity(), mCount));
+    widened.mCount = mCount;
+    for (int i = 0; i < mCount; i++) {
+        widened.store(i, at(i));
+    }
+    *this = widened;
+}
+
+void Column::store(int index, double value)
+{
+    char* p = valuePtr(index);
+    switch (mType) {
+    case TypeBool: *reinterpret_cast<quint8*>(p) = quint8(value); break;
+    case TypeInt8: *reinterpret_cast<qint8*>(p) = qint8(value); break;
+    case TypeInt16: *reinterpret_cast<qint16*>(p) = qint16(value); break;
+    case TypeInt32: *reinterpret_cast<qint32*>(p) = qint32(value); break;
+    case TypeFloat: *reinterpret_cast<float*>(p) = float(value); break;
+    case TypeDouble: *reinterpret_cast<double*>(p) = value; break;
+    }
+}
+
+// ===========================================================================
+
+ColumnView::ColumnView(const char *data, Column::Type type, int count, int stride)
+    : mData(data), mType(type), mCount(count), mStride(stride),
+      mByteStride(Column::typeSize(type) * stride)
+{
+
+}
+
+ColumnView ColumnView::mid(int startIndex, int length) const
+{
+    if ((startIndex < 0) || (startIndex >= mCount)) {
+        return ColumnView(nullptr, mType, 0, mStride);
+    }
+    if ((length < 0) || (length > mCount - startIndex)) {
+        length = mCount - startIndex;
+    }
+    return ColumnView(mData + qint64(startIndex) * mByteStride,
+                      mType, length, mStride);
+}
+
+ColumnView ColumnView::strided(int step) const
+{
+    if (step < 1) { step = 1; }
+    return ColumnView(mData, mType, (mCount + step - 1) / step, mStride * step);
+}
+
+QVector<double> ColumnView::toDoubles() const
+{
+    QVector<double> ret(mCount);
+    if (mCount == 0) { return ret; }
+
+    double* dst = ret.data();
+    switch (mType) {
+    case Column::TypeBool:
+        convert(reinterpret_cast<const quint8*>(mData), dst, mCount, mStride);
+        break;
+    case Column::TypeInt8:
+        convert(reinterpret_cast<const qint8*>(mData), dst, mCount, mStride);
+        break;
+    case Column::TypeInt16:
+        convert(reinterpret_cast<const qint16*>(mData), dst, mCount, mStride);
+        break;
+    case Column::TypeInt32:
+        convert(reinterpret_cast<const qint32*>(mData), dst, mCount, mStride);
+        break;
+    case Column::TypeFloat:
+        convert(reinterpret_cast<const float*>(mData), dst, mCount, mStride);
+        break;
+    case Column::TypeDouble:
+        if (mStride == 1) {
+            memcpy(dst, mData, mCount * sizeof(double));
+        } else {
+            convert(reinterpret_cast<const double*>(mData), dst, mCount, mStride);
+        }
+        break;
+    }
+    return ret;
+}
@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef COLUMN_H
+#define COLUMN_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/* Column stores the values of one matrix column in the narrowest type that
+ * holds all of them exactly. A new column starts out as bool and is widened
+ * when a value is appended that does not fit (bool -> int8 -> int16 -> int32,
+ * and float or double for non-integer values), converting the values stored
+ * so far. Widening happens at most a few times per column, so the cost is
+ * amortised over the import.
+ *
+ * Values are always read and written as double. Reading converts from the
+ * stored type, which is exact for all types.
+ *
+ * Values are stored in blocks so appending never moves the values stored so
+ * far, which for large columns would need memory for both the old and new
+ * buffer. The first block is sized by reserve(), e.g. from an estimate of the
+ * row count, and further blocks of a fixed size are added when it is full.
+ * consolidate() merges the blocks into one, which view() requires. */
+
+class ColumnView;
+
+class Column
+{
+public:
+    enum Type { TypeBool, TypeInt8, TypeInt16, TypeInt32, TypeFloat, TypeDouble };
+
+    Column();
+    // Empty column of a type known beforehand, which avoids widening
+    explicit Column(Type type);
+
+    Type type() const { return mType; }
+    static QString typeName(Type type);
+    static int typeSize(Type type);
+    // Narrowest type that holds value exactly
+    static Type typeFor(double value);
+    // Narrowest type that holds all values of types a and b exactly
+    static Type commonType(Type a, Type b);
+
+    int count() const { return mCount; }
+    bool isEmpty() const { return mCount == 0; }
+    // Bytes used by the values
+    qint64 memoryUsage() const;
+
+    double at(int index) const;
+    double last() const { return at(mCount - 1); }
+    // The following require the column to be contiguous
+    QVector<double> toDoubles(int startIndex, int length) const;
+    // View of length values from startIndex, or up to the end if length is
+    // -1 or exceeds it. Empty if startIndex is out of range.
+    ColumnView view(int startIndex = 0, int length = -1) const;
+
+    /* Column of count values of the specified type stored in data, e.g. from
+     * QByteArray::fromRawData() pointing into a memory-mapped file. Data is
+     * shared, not copied, until the column is modified. */
+    static Column fromData(Type type, int count, const QByteArray& data);
+
+    void append(double value);
+    void append(const double* values, int count);
+    void set(int index, double value);
+    // Added values are zero
+    void resize(int count);
+    // Make room for count values without adding blocks. Only has effect
+    // while the column is contiguous.
+    void reserve(int count);
+
+    bool isContiguous() const { return mBlocks.count() <= 1; }
+    // Merge blocks into one and release unused reserved memory
+    void consolidate();
+
+private:
+    Type mType = TypeBool;
+    int mCount = 0;
+
+    QVector<QByteArray> mBlocks;
+    // In number of values
+    int mFirstBlockCapacity = 0;
+    static const int blockBytes = 1024 * 1024;
+    int blockCapacity() const { return blockBytes / typeSize(mType); }
+    int capacity() const;
+    void addBlock();
+    // Number of values from index to the end of its block
+    int blockSpace(int index) const;
+    char* valuePtr(int index);
+    const char* valuePtr(int index) const;
+
+    static bool fits(Type type, double value);
+    void widen(Type type);
+    void store(int index, double value);
+};
+
+/* ColumnView is a read-only view of a range of column values, pointing into
+ * the column storage without copying it. Values may be strided, e.g. to take
+ * every n'th value. The view is only valid as long as the column exists and
+ * is not modified. */
+
+class ColumnView
+{
+public:
+    ColumnView() {}
+    ColumnView(const char* data, Column::Type type, int count, int stride = 1);
+
+    // First value, stored as type()
+    const char* data() const { return mData; }
+    Column::Type type() const { return mType; }
+    int count() const { return mCount; }
+    bool isEmpty() const { return mCount == 0; }
+    // Distance between consecutive values, in number of values
+    int stride() const { return mStride; }
+
+    double at(int index) const;
+    double operator[](int index) const { return at(index); }
+
+    ColumnView mid(int startIndex, int length = -1) const;
+    // Every step'th value, starting with the first
+    ColumnView strided(int step) const;
+    QVector<double> toDoubles() const;
+
+private:
+    const char* mData = nullptr;
+    Column::Type mType = Column::TypeDouble;
+    int mCount = 0;
+    int mStride = 1;
+    int mByteStride = sizeof(double);
+};
+
+inline double ColumnView::at(int index) const
+{
+    const char* p = mData + qint64(index) * mByteStride;
+    switch (mType) {
+    case Column::TypeBool: return *reinterpret_cast<const quint8*>(p);
+    case Column::TypeInt8: return *reinterpret_cast<const qint8*>(p);
+    case Column::TypeInt16: return *reinterpret_cast<const qint16*>(p);
+    case Column::TypeInt32: return *reinterpret_cast<const qint32*>(p);
+    case Column::TypeFloat: return *reinterpret_cast<const float*>(p);
+    case Column::TypeDouble: return *reinterpret_cast<const double*>(p);
+    }
+    return 0;
+}
+
+#endif // COLUMN_H
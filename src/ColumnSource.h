@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef COLUMNSOURCE_H
+#define COLUMNSOURCE_H
+
+#include "Column.h"
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+/* ColumnSource provides matrix column values that are read on demand, so
+ * only the columns (and rows) that are viewed or plotted are read, instead of
+ * the whole file on import. See Matrix::setSource().
+ *
+ * Rows are read in blocks, e.g. Parquet row groups, and only the blocks
+ * containing the rows needed are read. Columns are numbered from zero,
+ * without the matrix index column. */
+
+class ColumnSource
+{
+public:
+    virtual ~ColumnSource() {}
+
+    virtual int rowCount() const = 0;
+    virtual int columnCount() const = 0;
+    // May be fewer than columnCount()
+    virtual QStringList headings() const = 0;
+    // Type to store a column as. Values that don't fit widen it, so this can
+    // be the narrowest type if not known before reading.
+    virtual Column::Type columnType(int col) const = 0;
+    /* Rows at the start of a column that did not have a value and are
+     * backfilled with the value of the first row that has it. See Matrix
+     * for these and the error types below. */
+    virtual int backfilledRows(int /*col*/) const { return 0; }
+    // Whether the values of a column are timestamps in seconds since the
+    // epoch
+    virtual bool isTimeColumn(int /*col*/) const { return false; }
+    /* Whether a column holds text categories (see
+     * Matrix::isCategoryColumn()). Its values are read as Category entries
+     * of the errors, not as numbers. */
+    virtual bool isCategoryColumn(int /*col*/) const { return false; }
+
+    virtual int blockCount() const = 0;
+    // First row of a block. Blocks are consecutive, so block i ends where
+    // block i + 1 starts. blockStart(blockCount()) is rowCount().
+    virtual int blockStart(int block) const = 0;
+    // Whether readBlock() may be called from several threads at once
+    virtual bool isThreadSafe() const { return false; }
+
+    struct Error
+    {
+        enum Type {
+            // No value. Gets the previous row's value.
+            Null,
+            // Value text could not be converted. Gets the previous row's
+            // value.
+            ConversionError,
+            // Row has too few fields. Gets the previous row's value.
+            MissingField,
+            // First row of a column added by a row with more fields than the
+            // rows before it. Keeps its value.
+            ExcessField,
+            // Not an error: text of a category column value, which the
+            // matrix stores as the code of the text
+            Category
+        };
+        Type type = Null;
+        // Relative to the first row read
+        int row = 0;
+        // Of a conversion error or category
+        QByteArray text;
+    };
+
+    /* Read the values of a block of a column. Rows with errors, in row
+     * order, are added to errors. Values of error rows are replaced by the
+     * matrix. Returns false if the block can't be read, with error set. */
+    virtual bool readBlock(int col, int block, QVector<double>& values,
+                           QVector<Error>& errors, QString& error) = 0;
+    /* Read a block of several columns, values[i] and errors[i] being those
+     * of cols[i]. Sources that have to read all columns of a row anyway,
+     * like CSV, read them all in one go. */
+    virtual bool readColumnsBlock(const QVector<int>& cols, int block,
+                                  QVector<QVector<double>>& values,
+                                  QVector<QVector<Error>>& errors,
+                                  QString& error)
+    {
+        values.resize(cols.count());
+        errors.resize(cols.count());
+        for (int i = 0; i < cols.count(); i++) {
+            if (!readBlock(cols[i], block, values[i], errors[i], error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* Whether a few rows can be read without reading whole blocks, so rows
+     * of all columns can be shown, e.g. in a table, without reading the
+     * columns. See readRows(). */
+    virtual bool hasRowAccess() const { return false; }
+    // Read rows [first, first + count) of columns. Only if hasRowAccess().
+    virtual bool readRows(const QVector<int>& /*cols*/, int /*first*/,
+                          int /*count*/, QVector<QVector<double>>& /*values*/,
+                          QVector<QVector<Error>>& /*errors*/, QString& error)
+    {
+        error = "Not supported";
+        return false;
+    }
+};
+typedef QSharedPointer<ColumnSource> ColumnSourcePtr;
+
+#endif // COLUMNSOURCE_H
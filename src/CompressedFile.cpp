@@ -0,0 +1,459 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "CompressedFile.h"
+#include "defer.h"
+
+#include <QThread>
+
+#include <cstring>
+
+#ifdef GIDPLOT_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef GIDPLOT_ZSTD
+    #include <zstd.h>
+#endif
+
+class CompressedFile::DecompressThread : public QThread
+{
+public:
+    explicit DecompressThread(CompressedFile* file) : mFile(file) {}
+
+protected:
+    void run() override
+    {
+        mFile->decompress();
+    }
+
+private:
+    CompressedFile* mFile;
+};
+
+CompressedFile::CompressedFile(QString filename, QObject* parent)
+    : QIODevice(parent), mFile(filename)
+{
+
+}
+
+CompressedFile::~CompressedFile()
+{
+    close();
+}
+
+CompressedFile::Compression CompressedFile::compression(QIODevice& device)
+{
+    QByteArray magic = device.peek(4);
+    if (magic.startsWith("\x1f\x8b")) {
+        return Gzip;
+    } else if (magic == QByteArray("\x28\xb5\x2f\xfd", 4)) {
+        return Zstd;
+    }
+    return NoCompression;
+}
+
+CompressedFile::Compression CompressedFile::compression(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) { return NoCompression; }
+    return compression(file);
+}
+
+QString CompressedFile::compressionName(Compression compression)
+{
+    switch (compression) {
+    case Gzip:
+        return "gzip";
+    case Zstd:
+        return "zstd";
+    default:
+        return "";
+    }
+}
+
+bool CompressedFile::isSupported(Compression compression)
+{
+    switch (compression) {
+#ifdef GIDPLOT_ZLIB
+    case Gzip:
+        return true;
+#endif
+#ifdef GIDPLOT_ZSTD
+    case Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool CompressedFile::open(OpenMode mode)
+{
+    if (isOpen()) { return false; }
+    if ((mode & ReadWrite) != ReadOnly) {
+        setErrorString("Compressed files can only be read");
+        return false;
+    }
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        setErrorString(mFile.errorString());
+        return false;
+    }
+    mCompression = compression(mFile);
+    if (mCompression == NoCompression) {
+        mFile.close();
+        setErrorString("File is not gzip or zstd compressed");
+        return false;
+    }
+    if (!isSupported(mCompression)) {
+        mFile.close();
+        setErrorString(QString("Opening %1 compressed files is not supported "
+                               "in this build")
+                       .arg(compressionName(mCompression)));
+        return false;
+    }
+    mCompressedSize = mFile.size();
+
+    mBlocks.clear();
+    mFinished = false;
+    mAbort = false;
+    mError.clear();
+    mCompressedRead.storeRelease(0);
+    mDecompressedSize.storeRelease(0);
+    mCurrent = Block();
+    mCurrentPos = 0;
+
+    // Data is already in blocks, QIODevice buffering would only add a copy
+    QIODevice::open(mode | Unbuffered);
+
+    mThread = new DecompressThread(this);
+    mThread->start();
+    return true;
+}
+
+void CompressedFile::close()
+{
+    if (mThread) {
+        {
+            QMutexLocker locker(&mMutex);
+            mAbort = true;
+            mBlockTaken.wakeAll();
+        }
+        mThread->wait();
+        delete mThread;
+        mThread = nullptr;
+    }
+    mFile.close();
+    mBlocks.clear();
+    mCurrent = Block();
+    mCurrentPos = 0;
+    QIODevice::close();
+}
+
+bool CompressedFile::isSequential() const
+{
+    return true;
+}
+
+bool CompressedFile::atEnd() const
+{
+    if (!isOpen()) { return true; }
+    if (mCurrentPos < mCurrent.data.size()) { return false; }
+
+    QMutexLocker locker(&mMutex);
+    while (mBlocks.isEmpty() && !mFinished) {
+        mBlockQueued.wait(&mMutex);
+    }
+    return mBlocks.isEmpty();
+}
+
+qint64 CompressedFile::bytesAvailable() const
+{
+    return QIODevice::bytesAvailable() + (mCurrent.data.size() - mCurrentPos);
+}
+
+CompressedFile::Compression CompressedFile::compression() const
+{
+    return mCompression;
+}
+
+qint64 CompressedFile::compressedSize() const
+{
+    return mCompressedSize;
+}
+
+qint64 CompressedFile::compressedPos() const
+{
+    return mCurrent.compressedEnd;
+}
+
+qint64 CompressedFile::estimatedSize() const
+{
+    qint64 compressed = mCompressedRead.loadAcquire();
+    qint64 decompressed = mDecompressedSize.loadAcquire();
+    if (compressed <= 0) { return decompressed; }
+    return qint64(double(decompressed) / compressed * mCompressedSize);
+}
+
+QString CompressedFile::decompressError() const
+{
+    QMutexLocker locker(&mMutex);
+    return mError;
+}
+
+qint64 CompressedFile::readData(char* data, qint64 maxSize)
+{
+    qint64 count = 0;
+    while (count < maxSize) {
+        if ((mCurrentPos >= mCurrent.data.size()) && !nextBlock()) { break; }
+        int n = int(qMin<qint64>(maxSize - count,
+                                 mCurrent.data.size() - mCurrentPos));
+        memcpy(data + count, mCurrent.data.constData() + mCurrentPos, n);
+        count += n;
+        mCurrentPos += n;
+    }
+    return count;
+}
+
+qint64 CompressedFile::readLineData(char* data, qint64 maxSize)
+{
+    // Same as readData(), but up to and including the first newline
+    qint64 count = 0;
+    while (count < maxSize) {
+        if ((mCurrentPos >= mCurrent.data.size()) && !nextBlock()) { break; }
+        const char* src = mCurrent.data.constData() + mCurrentPos;
+        int n = int(qMin<qint64>(maxSize - count,
+                                 mCurrent.data.size() - mCurrentPos));
+        const char* newline = static_cast<const char*>(memchr(src, '\n', n));
+        if (newline) {
+            n = int(newline - src) + 1;
+        }
+        memcpy(data + count, src, n);
+        count += n;
+        mCurrentPos += n;
+        if (newline) { break; }
+    }
+    return count;
+}
+
+qint64 CompressedFile::writeData(const char* /*data*/, qint64 /*maxSize*/)
+{
+    return -1;
+}
+
+bool CompressedFile::nextBlock()
+{
+    QMutexLocker locker(&mMutex);
+    while (mBlocks.isEmpty() && !mFinished) {
+        mBlockQueued.wait(&mMutex);
+    }
+    if (mBlocks.isEmpty()) { return false; }
+    mCurrent = mBlocks.dequeue();
+    mCurrentPos = 0;
+    mBlockTaken.wakeAll();
+    return true;
+}
+
+void CompressedFile::decompress()
+{
+    QString error;
+    bool ok = false;
+    if (mCompression == Gzip) {
+        ok = decompressGzip(error);
+    } else if (mCompression == Zstd) {
+        ok = decompressZstd(error);
+    }
+
+    QMutexLocker locker(&mMutex);
+    if (!ok && !mAbort) {
+        mError = error;
+    }
+    mFinished = true;
+    mBlockQueued.wakeAll();
+}
+
+bool CompressedFile::queueBlock(const QByteArray& data, qint64 compressedEnd)
+{
+    mCompressedRead.storeRelease(compressedEnd);
+    mDecompressedSize.fetchAndAddRelease(data.size());
+
+    QMutexLocker locker(&mMutex);
+    while ((mBlocks.count() >= maxQueuedBlocks) && !mAbort) {
+        mBlockTaken.wait(&mMutex);
+    }
+    if (mAbort) { return false; }
+    Block block;
+    block.data = data;
+    block.compressedEnd = compressedEnd;
+    mBlocks.enqueue(block);
+    mBlockQueued.wakeAll();
+    return true;
+}
+
+bool CompressedFile::decompressGzip(QString& error)
+{
+#ifdef GIDPLOT_ZLIB
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // 32: detect gzip or zlib header
+    if (inflateInit2(&z, 15 + 32) != Z_OK) {
+        error = "Could not initialise zlib";
+        return false;
+    }
+    Defer d([&]() { inflateEnd(&z); });
+
+    QByteArray input(inputSize, Qt::Uninitialized);
+    QByteArray output(blockSize, Qt::Uninitialized);
+    qint64 inputTotal = 0;
+    bool streamEnded = false;
+    bool outputFull = false;
+
+    auto queueOutput = [&]() -> bool
+    {
+        output.resize(blockSize - int(z.avail_out));
+        if (output.isEmpty()) { return true; }
+        bool queued = queueBlock(output, inputTotal - z.avail_in);
+        output = QByteArray(blockSize, Qt::Uninitialized);
+        return queued;
+    };
+
+    z.next_out = reinterpret_cast<Bytef*>(output.data());
+    z.avail_out = blockSize;
+
+    forever {
+        // Output may still be pending if the last call filled the buffer
+        if ((z.avail_in == 0) && !outputFull) {
+            qint64 n = mFile.read(input.data(), input.size());
+            if (n < 0) {
+                error = mFile.errorString();
+                queueOutput();
+                return false;
+            }
+            if (n == 0) { break; }
+            inputTotal += n;
+            z.next_in = reinterpret_cast<Bytef*>(input.data());
+            z.avail_in = uInt(n);
+        }
+        if (streamEnded && (z.avail_in > 0)) {
+            // Files can consist of several concatenated gzip members
+            inflateReset(&z);
+            streamEnded = false;
+        }
+
+        int ret = inflate(&z, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            streamEnded = true;
+        } else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+            error = z.msg ? QString(z.msg) : QString("zlib error %1").arg(ret);
+            queueOutput();
+            return false;
+        }
+
+        outputFull = (z.avail_out == 0);
+        if (outputFull) {
+            if (!queueOutput()) { return false; }
+            z.next_out = reinterpret_cast<Bytef*>(output.data());
+            z.avail_out = blockSize;
+        }
+    }
+
+    if (!queueOutput()) { return false; }
+    if (!streamEnded) {
+        error = "Unexpected end of file";
+        return false;
+    }
+    return true;
+#else
+    error = "Not supported in this build";
+    return false;
+#endif
+}
+
+bool CompressedFile::decompressZstd(QString& error)
+{
+#ifdef GIDPLOT_ZSTD
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if (!stream) {
+        error = "Could not initialise zstd";
+        return false;
+    }
+    Defer d([&]() { ZSTD_freeDStream(stream); });
+    ZSTD_initDStream(stream);
+
+    QByteArray input(inputSize, Qt::Uninitialized);
+    QByteArray output(blockSize, Qt::Uninitialized);
+    qint64 inputTotal = 0;
+    ZSTD_inBuffer in = { input.constData(), 0, 0 };
+    ZSTD_outBuffer out = { output.data(), size_t(blockSize), 0 };
+    // Zero when a frame has been completely decoded
+    size_t ret = 0;
+    bool outputFull = false;
+
+    auto queueOutput = [&]() -> bool
+    {
+        output.resize(int(out.pos));
+        if (output.isEmpty()) { return true; }
+        bool queued = queueBlock(output, inputTotal - qint64(in.size - in.pos));
+        output = QByteArray(blockSize, Qt::Uninitialized);
+        return queued;
+    };
+
+    forever {
+        // Output may still be pending if the last call filled the buffer
+        if ((in.pos == in.size) && !outputFull) {
+            qint64 n = mFile.read(input.data(), input.size());
+            if (n < 0) {
+                error = mFile.errorString();
+                queueOutput();
+                return false;
+            }
+            if (n == 0) { break; }
+            inputTotal += n;
+            in.size = size_t(n);
+            in.pos = 0;
+        }
+
+        // Concatenated frames are decoded one after the other
+        ret = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(ret)) {
+            error = ZSTD_getErrorName(ret);
+            queueOutput();
+            return false;
+        }
+
+        outputFull = (out.pos == out.size);
+        if (outputFull) {
+            if (!queueOutput()) { return false; }
+            out.dst = output.data();
+            out.pos = 0;
+        }
+    }
+
+    if (!queueOutput()) { return false; }
+    if (ret != 0) {
+        error = "Unexpected end of file";
+        return false;
+    }
+    return true;
+#else
+    error = "Not supported in this build";
+    return false;
+#endif
+}
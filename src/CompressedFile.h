@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QAtomicInteger>
+#include <QFile>
+#include <QIODevice>
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+/* CompressedFile reads a gzip or zstd compressed file as a sequential device,
+ * decompressing on the fly.
+ *
+ * Decompression runs in its own thread, which stays up to a few blocks ahead
+ * of the reader, so decompressing and parsing overlap. Read it like a QFile
+ * opened for reading (readLine(), atEnd(), text mode); it can't seek.
+ *
+ * Support for each format depends on the libraries found when building (see
+ * gidplot.pro). */
+
+class CompressedFile : public QIODevice
+{
+    Q_OBJECT
+public:
+    enum Compression { NoCompression, Gzip, Zstd };
+
+    explicit CompressedFile(QString filename, QObject* parent = nullptr);
+    ~CompressedFile();
+
+    // Compression of a file, from the magic bytes at its start
+    static Compression compression(QIODevice& device);
+    static Compression compression(QString filename);
+    static QString compressionName(Compression compression);
+    // Whether this build can decompress the format
+    static bool isSupported(Compression compression);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+
+    Compression compression() const;
+    qint64 compressedSize() const;
+    // Compressed bytes consumed for the data read so far, for progress
+    qint64 compressedPos() const;
+    // Decompressed size, estimated from the compression ratio so far
+    qint64 estimatedSize() const;
+    // Empty unless decompressing failed, in which case the data ends early
+    QString decompressError() const;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 readLineData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    class DecompressThread;
+
+    QFile mFile;
+    Compression mCompression = NoCompression;
+    qint64 mCompressedSize = 0;
+    DecompressThread* mThread = nullptr;
+
+    // Decompressed blocks, handed from the decompress thread to the reader
+    struct Block
+    {
+        QByteArray data;
+        // Compressed bytes consumed up to the end of this block
+        qint64 compressedEnd = 0;
+    };
+    static const int blockSize = 1024 * 1024;
+    static const int maxQueuedBlocks = 4;
+    mutable QMutex mMutex;
+    mutable QWaitCondition mBlockQueued;
+    QWaitCondition mBlockTaken;
+    QQueue<Block> mBlocks;
+    bool mFinished = false;
+    bool mAbort = false;
+    QString mError;
+    QAtomicInteger<qint64> mCompressedRead;
+    QAtomicInteger<qint64> mDecompressedSize;
+
+    // Block being read
+    Block mCurrent;
+    int mCurrentPos = 0;
+    // Make the next queued block current, waiting for it if necessary.
+    // Returns false at the end of the data.
+    bool nextBlock();
+
+    // Decompress thread
+    void decompress();
+    bool decompressGzip(QString& error);
+    bool decompressZstd(QString& error);
+    static const int inputSize = 256 * 1024;
+    // Queue a decompressed block, waiting while the queue is full. Returns
+    // false if the file was closed meanwhile.
+    bool queueBlock(const QByteArray& data, qint64 compressedEnd);
+};
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,290 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "CsvCache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <limits>
+
+namespace {
+
+const char* magic = "GidPlotCache";
+
+enum ErrorFlag {
+    ValueConversionFlag = 1,
+    ExcessColsFlag = 2,
+    InsufficientColsFlag = 4,
+    DefaultedToZeroFlag = 8
+};
+
+} // namespace
+
+CsvCache::Key CsvCache::Key::fromFileInfo(const Csv::FileInfo &fileInfo)
+{
+    QFileInfo info(fileInfo.filename);
+    Key key;
+    key.filename = info.absoluteFilePath();
+    key.size = info.size();
+    key.modified = info.lastModified().toMSecsSinceEpoch();
+    key.headings = fileInfo.headings;
+    key.dataStartRow = fileInfo.dataStartRow;
+    key.separator = fileInfo.separator;
+    key.combineSeparators = fileInfo.combineSeparators;
+    return key;
+}
+
+bool CsvCache::Key::operator==(const Key &other) const
+{
+    return (filename == other.filename)
+            && (size == other.size)
+            && (modified == other.modified)
+            && (headings == other.headings)
+            && (dataStartRow == other.dataStartRow)
+            && (separator == other.separator)
+            && (combineSeparators == other.combineSeparators);
+}
+
+void CsvCache::Key::write(QDataStream &out) const
+{
+    out << filename << size << modified << headings << dataStartRow
+        << separator << combineSeparators;
+}
+
+void CsvCache::Key::read(QDataStream &in)
+{
+    in >> filename >> size >> modified >> headings >> dataStartRow
+       >> separator >> combineSeparators;
+}
+
+QString CsvCache::cacheFilename(QString filename)
+{
+    return filename + ".gidplotcache";
+}
+
+bool CsvCache::load(CsvPtr csv, qint64 &importedSize)
+{
+    QSharedPointer<QFile> file(new QFile(cacheFilename(csv->fileInfo.filename)));
+    if (!file->open(QIODevice::ReadOnly)) { return false; }
+
+    QDataStream in(file.data());
+    in.setVersion(QDataStream::Qt_5_0);
+    QByteArray fileMagic;
+    quint32 fileVersion = 0;
+    quint8 byteOrder = 0;
+    qint64 headerSize = 0;
+    in >> fileMagic >> fileVersion >> byteOrder >> headerSize;
+    if ((in.status() != QDataStream::Ok) || (fileMagic != magic)
+            || (fileVersion != version)
+            || (byteOrder != quint8(QSysInfo::ByteOrder))
+            || (headerSize < 0) || (headerSize > file->size())) {
+        return false;
+    }
+    QByteArray header = file->read(headerSize);
+    if (header.size() != headerSize) { return false; }
+    qint64 dataStart = aligned(file->pos());
+
+    QDataStream h(header);
+    h.setVersion(QDataStream::Qt_5_0);
+
+    Key key;
+    key.read(h);
+    if (!(key == Key::fromFileInfo(csv->fileInfo))) {
+        // File or import settings changed
+        return false;
+    }
+    qint64 size = 0;
+    h >> size;
+    if ((size != key.size) && !csv->fileInfo.follow) {
+        // Lines written after the import would be missing. When following,
+        // they are read after loading.
+        return false;
+    }
+
+    QStringList headings;
+    qint32 errorCount = 0;
+    qint32 valueConversionErrorCount = 0;
+    qint32 excessColsErrorCount = 0;
+    qint32 insufficientColsErrorCount = 0;
+    QVector<int> backfilledRows;
+    QVector<bool> timeCols;
+    QVector<bool> categoryCols;
+    QVector<QVector<QByteArray>> categoryTexts;
+    h >> headings >> errorCount >> valueConversionErrorCount
+      >> excessColsErrorCount >> insufficientColsErrorCount >> backfilledRows
+      >> timeCols >> categoryCols >> categoryTexts;
+
+    qint32 errorEntries = 0;
+    h >> errorEntries;
+    QMap<qint64, Matrix::MetaData> errors;
+    for (int i = 0; (i < errorEntries) && (h.status() == QDataStream::Ok); i++) {
+        qint64 cellKey = 0;
+        quint8 flags = 0;
+        qint32 backfilledFromRow = -1;
+        Matrix::MetaData md;
+        h >> cellKey >> flags >> backfilledFromRow >> md.originalText;
+        md.valueConversionError = flags & ValueConversionFlag;
+        md.excessColsError = flags & ExcessColsFlag;
+        md.insufficientColsError = flags & InsufficientColsFlag;
+        md.defaultedToZero = flags & DefaultedToZeroFlag;
+        md.backfilledFromRow = backfilledFromRow;
+        md.column = int(cellKey & 0xFFFFFFFF);
+        errors.insert(cellKey, md);
+    }
+
+    qint32 colCount = 0;
+    h >> colCount;
+    if ((h.status() != QDataStream::Ok) || (colCount < 1)
+            || (backfilledRows.count() != colCount)) {
+        return false;
+    }
+
+    // Check columns are within the file before mapping it
+    QVector<qint32> types(colCount);
+    QVector<qint32> counts(colCount);
+    QVector<qint64> offsets(colCount);
+    for (int i = 0; i < colCount; i++) {
+        h >> types[i] >> counts[i] >> offsets[i];
+        if ((types[i] < Column::TypeBool) || (types[i] > Column::TypeDouble)
+                || (counts[i] != counts[0]) || (offsets[i] < 0)) {
+            return false;
+        }
+        qint64 bytes = qint64(counts[i]) * Column::typeSize(Column::Type(types[i]));
+        if ((bytes > std::numeric_limits<int>::max())
+                || (dataStart + offsets[i] + bytes > file->size())) {
+            return false;
+        }
+    }
+    if (h.status() != QDataStream::Ok) { return false; }
+
+    uchar* data = file->map(0, file->size());
+    if (!data) { return false; }
+
+    MatrixPtr matrix(new Matrix(colCount - 1));
+    matrix->mHeadings = headings;
+    matrix->mErrorCount = errorCount;
+    matrix->mValueConversionErrorCount = valueConversionErrorCount;
+    matrix->mExcessColsErrorCount = excessColsErrorCount;
+    matrix->mInsufficientColsErrorCount = insufficientColsErrorCount;
+    matrix->mBackfilledRows = backfilledRows;
+    matrix->mTimeCols = timeCols;
+    matrix->mCategoryCols = categoryCols;
+    matrix->mCategories.resize(categoryTexts.count());
+    for (int col = 0; col < categoryTexts.count(); col++) {
+        Matrix::Categories& categories = matrix->mCategories[col];
+        categories.texts = categoryTexts[col];
+        for (int code = 0; code < categories.texts.count(); code++) {
+            categories.codes.insert(categories.texts[code], code);
+        }
+    }
+    matrix->mErrors = errors;
+    matrix->mCacheFile = file;
+    for (int i = 0; i < colCount; i++) {
+        Column::Type type = Column::Type(types[i]);
+        const char* colData = reinterpret_cast<const char*>(data + dataStart + offsets[i]);
+        int bytes = counts[i] * Column::typeSize(type);
+        matrix->mDataCols[i] = Column::fromData(
+                    type, counts[i], QByteArray::fromRawData(colData, bytes));
+    }
+
+    csv->matrix = matrix;
+    importedSize = size;
+    return true;
+}
+
+bool CsvCache::save(CsvPtr csv, const Key &key, qint64 importedSize,
+                    QString &errorString)
+{
+    MatrixPtr matrix = csv->matrix;
+    int colCount = matrix->colCount();
+
+    QByteArray header;
+    QDataStream h(&header, QIODevice::WriteOnly);
+    h.setVersion(QDataStream::Qt_5_0);
+
+    key.write(h);
+    h << importedSize;
+    h << matrix->mHeadings << qint32(matrix->mErrorCount)
+      << qint32(matrix->mValueConversionErrorCount)
+      << qint32(matrix->mExcessColsErrorCount)
+      << qint32(matrix->mInsufficientColsErrorCount)
+      << matrix->mBackfilledRows << matrix->mTimeCols << matrix->mCategoryCols;
+    // Only the texts, the codes are rebuilt on loading
+    QVector<QVector<QByteArray>> categoryTexts;
+    foreach (const Matrix::Categories& categories, matrix->mCategories) {
+        categoryTexts.append(categories.texts);
+    }
+    h << categoryTexts;
+
+    h << qint32(matrix->mErrors.count());
+    for (auto it = matrix->mErrors.constBegin(); it != matrix->mErrors.constEnd(); ++it) {
+        const Matrix::MetaData& md = it.value();
+        quint8 flags = (md.valueConversionError ? ValueConversionFlag : 0)
+                | (md.excessColsError ? ExcessColsFlag : 0)
+                | (md.insufficientColsError ? InsufficientColsFlag : 0)
+                | (md.defaultedToZero ? DefaultedToZeroFlag : 0);
+        h << it.key() << flags << qint32(md.backfilledFromRow) << md.originalText;
+    }
+
+    h << qint32(colCount);
+    QVector<ColumnView> views;
+    qint64 offset = 0;
+    for (int i = 0; i < colCount; i++) {
+        ColumnView view = matrix->columnView(i);
+        views.append(view);
+        h << qint32(view.type()) << qint32(view.count()) << offset;
+        offset = aligned(offset + qint64(view.count()) * Column::typeSize(view.type()));
+    }
+
+    // Written to a temporary file first, so a cache is never left incomplete
+    QSaveFile file(cacheFilename(csv->fileInfo.filename));
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorString = file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << QByteArray(magic) << version << quint8(QSysInfo::ByteOrder)
+        << qint64(header.size());
+    file.write(header);
+
+    // Column values as stored, each aligned
+    qint64 dataStart = aligned(file.pos());
+    file.write(QByteArray(int(dataStart - file.pos()), '\0'));
+    foreach (const ColumnView& view, views) {
+        qint64 bytes = qint64(view.count()) * Column::typeSize(view.type());
+        file.write(view.data(), bytes);
+        file.write(QByteArray(int(aligned(bytes) - bytes), '\0'));
+    }
+
+    if (!file.commit()) {
+        errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 CsvCache::aligned(qint64 pos)
+{
+    return (pos + alignment - 1) / alignment * alignment;
+}
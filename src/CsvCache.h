@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef CSVCACHE_H
+#define CSVCACHE_H
+
+#include "csv.h"
+
+#include <QDataStream>
+
+/* CsvCache saves the imported data of a CSV file to a binary cache file next
+ * to it, so the next time the file is opened it doesn't need to be parsed.
+ *
+ * The cache file holds the column values as stored in the matrix (see
+ * Column), the headings, the error metadata, the category texts and the
+ * import settings. On loading, the columns point straight into the
+ * memory-mapped cache file.
+ *
+ * A cache is only used if the path, size and modification time of the CSV
+ * file and the import settings that affect the data all match. Otherwise
+ * the file is imported as usual and the cache is replaced. */
+
+class CsvCache
+{
+public:
+    // Identifies the CSV file and the import settings that affect the data
+    struct Key
+    {
+        QString filename;
+        qint64 size = 0;
+        qint64 modified = 0;
+        QStringList headings;
+        qint32 dataStartRow = 0;
+        qint8 separator = ',';
+        bool combineSeparators = false;
+
+        // Key of the file in its current state
+        static Key fromFileInfo(const Csv::FileInfo& fileInfo);
+        bool operator==(const Key& other) const;
+        void write(QDataStream& out) const;
+        void read(QDataStream& in);
+    };
+
+    static QString cacheFilename(QString filename);
+    // Smaller files import quickly enough without a cache
+    static const qint64 minFileSize = 16 * 1024 * 1024;
+
+    /* Load the matrix of csv from its cache file. Returns false if there is
+     * no valid cache for the file and import settings. Otherwise
+     * importedSize is set to the number of bytes of the file the cache was
+     * made from. */
+    static bool load(CsvPtr csv, qint64& importedSize);
+    /* Save the matrix of csv after import. key should be taken before the
+     * import started, so the cache is not used if the file changed while
+     * importing. Returns false on error. */
+    static bool save(CsvPtr csv, const Key& key, qint64 importedSize,
+                     QString& errorString);
+
+private:
+    static const quint32 version = 3;
+    // Column data offsets are aligned to this
+    static const int alignment = 64;
+    static qint64 aligned(qint64 pos);
+};
+
+#endif // CSVCACHE_H
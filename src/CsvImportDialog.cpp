@@ -20,8 +20,10 @@
 
 #include "CsvImportDialog.h"
 #include "ui_CsvImportDialog.h"
+#include "CompressedFile.h"
 
 #include <QFileInfo>
+#include <QScopedPointer>
 #include <QScrollBar>
 
 CsvImportDialog::CsvImportDialog(QWidget *parent) :
@@ -44,16 +46,35 @@ void CsvImportDialog::setFile(QString filename)
 
     fileInfo.filename = filename;
     ui->lineEdit_filename->setText(filename);
-    ui->label_fileSize->setText(QString("File size: %1")
-                                    .arg(QLocale().formattedDataSize(
-                                        QFileInfo(filename).size())));
+    QString sizeText = QString("File size: %1")
+            .arg(QLocale().formattedDataSize(QFileInfo(filename).size()));
 
     lines.clear();
 
-    QFile file(filename);
+    // Compressed files are previewed decompressed. They can only be read
+    // from start to end, so can't be memory-mapped, followed or read lazily.
+    CompressedFile::Compression compression = CompressedFile::compression(filename);
+    bool compressed = (compression != CompressedFile::NoCompression);
+    if (compressed) {
+        sizeText += QString(" (%1 compressed)")
+                .arg(CompressedFile::compressionName(compression));
+    }
+    ui->label_fileSize->setText(sizeText);
+    ui->checkBox_memoryMap->setEnabled(!compressed);
+    ui->checkBox_follow->setEnabled(!compressed);
+    ui->checkBox_lazy->setEnabled(!compressed);
+    ui->checkBox_lazy->setChecked(QFileInfo(filename).size() >= lazyDefaultSize);
+
+    QScopedPointer<QIODevice> device;
+    if (compressed) {
+        device.reset(new CompressedFile(filename));
+    } else {
+        device.reset(new QFile(filename));
+    }
+    QIODevice& file = *device;
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         // Error opening file
-        msgBox("Error opening file " + filename);
+        msgBox("Error opening file " + filename + ": " + file.errorString());
         this->hide();
         return;
     } else {
@@ -147,6 +168,12 @@ void CsvImportDialog::on_pushButton_import_clicked()
         fileInfo.separator = ';';
     }
     fileInfo.combineSeparators = ui->checkBox_combineSeparators->isChecked();
+    fileInfo.memoryMap = ui->checkBox_memoryMap->isChecked();
+    fileInfo.follow = ui->checkBox_follow->isEnabled()
+            && ui->checkBox_follow->isChecked();
+    fileInfo.lazy = ui->checkBox_lazy->isEnabled()
+            && ui->checkBox_lazy->isChecked();
+    fileInfo.useCache = ui->checkBox_cache->isChecked();
 
     // Determine headings based on headings text box content
     QString headingText = ui->lineEdit_headings->text().trimmed();
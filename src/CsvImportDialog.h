@@ -52,6 +52,9 @@ private:
     Ui::CsvImportDialog *ui;
     Csv::FileInfo fileInfo;
     QByteArrayList lines;
+    // Files of this size or more are read lazily by default, so they can be
+    // viewed seconds after opening them
+    static const qint64 lazyDefaultSize = 1024LL * 1024 * 1024;
 
     void msgBox(QString msg);
 };
@@ -0,0 +1,331 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "CsvScanner.h"
+
+#include <QtAlgorithms>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) \
+        || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define CSVSCANNER_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define CSVSCANNER_TARGET_AVX2
+    #else
+        #define CSVSCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace {
+
+const int blockSize = 64;
+
+struct Masks
+{
+    quint64 separator = 0;
+    quint64 newline = 0;
+    quint64 quote = 0;
+};
+
+typedef Masks (*MaskFunc)(const char* block, char separator);
+
+Masks masksScalar(const char* block, char separator)
+{
+    Masks m;
+    for (int i = 0; i < blockSize; i++) {
+        quint64 bit = quint64(1) << i;
+        char c = block[i];
+        if (c == separator) { m.separator |= bit; }
+        if (c == '\n') { m.newline |= bit; }
+        if (c == '"') { m.quote |= bit; }
+    }
+    return m;
+}
+
+#ifdef CSVSCANNER_X86
+
+Masks masksSse2(const char* block, char separator)
+{
+    const __m128i vsep = _mm_set1_epi8(separator);
+    const __m128i vnewline = _mm_set1_epi8('\n');
+    const __m128i vquote = _mm_set1_epi8('"');
+
+    Masks m;
+    for (int i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        int shift = 16 * i;
+        m.separator |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vsep)))) << shift;
+        m.newline |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vnewline)))) << shift;
+        m.quote |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vquote)))) << shift;
+    }
+    return m;
+}
+
+CSVSCANNER_TARGET_AVX2
+Masks masksAvx2(const char* block, char separator)
+{
+    const __m256i vsep = _mm256_set1_epi8(separator);
+    const __m256i vnewline = _mm256_set1_epi8('\n');
+    const __m256i vquote = _mm256_set1_epi8('"');
+
+    Masks m;
+    for (int i = 0; i < 2; i++) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        int shift = 32 * i;
+        m.separator |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vsep)))) << shift;
+        m.newline |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vnewline)))) << shift;
+        m.quote |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vquote)))) << shift;
+    }
+    return m;
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) { return false; }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) { return false; }
+    // Check that the OS saves the YMM registers
+    if ((_xgetbv(0) & 0x6) != 0x6) { return false; }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // CSVSCANNER_X86
+
+CsvScanner::Isa bestIsa()
+{
+#ifdef CSVSCANNER_X86
+    if (cpuSupportsAvx2()) { return CsvScanner::IsaAvx2; }
+    return CsvScanner::IsaSse2;
+#else
+    return CsvScanner::IsaScalar;
+#endif
+}
+
+CsvScanner::Isa& currentIsa()
+{
+    static CsvScanner::Isa isa = bestIsa();
+    return isa;
+}
+
+MaskFunc maskFunc(CsvScanner::Isa isa)
+{
+    switch (isa) {
+#ifdef CSVSCANNER_X86
+    case CsvScanner::IsaAvx2:
+        return masksAvx2;
+    case CsvScanner::IsaSse2:
+        return masksSse2;
+#endif
+    default:
+        return masksScalar;
+    }
+}
+
+// Field separation state of the line being scanned
+struct LineState
+{
+    const char* lineStart = nullptr;
+    const char* fieldStart = nullptr;
+    int lineCount = 0;
+
+    QVector<ByteSpan>* fields = nullptr;
+    QVector<int>* lineFieldIndex = nullptr;
+    bool combine = false;
+
+    void addField(const char* start, const char* end)
+    {
+        // Remove surrounding quotes. Quotes inside are doubled.
+        bool escapedQuotes = false;
+        if (((end - start) >= 2) && (*start == '"') && (*(end - 1) == '"')) {
+            start++;
+            end--;
+            escapedQuotes = (memchr(start, '"', end - start) != nullptr);
+        }
+        ByteSpan field(start, end - start);
+        field.escapedQuotes = escapedQuotes;
+        fields->append(field);
+    }
+
+    void separator(const char* pos)
+    {
+        if (combine && (pos == fieldStart)) {
+            // Leading or contiguous separator
+            fieldStart = pos + 1;
+            return;
+        }
+        addField(fieldStart, pos);
+        fieldStart = pos + 1;
+    }
+
+    void newline(const char* pos)
+    {
+        const char* fieldEnd = pos;
+        if ((fieldEnd > fieldStart) && (*(fieldEnd - 1) == '\r')) { fieldEnd--; }
+
+        int lineFieldCount = fields->count() - lineFieldIndex->last();
+        bool trailingSeparator = combine && (fieldEnd == fieldStart)
+                && (lineFieldCount > 0);
+        if (!trailingSeparator) {
+            addField(fieldStart, fieldEnd);
+        }
+        lineFieldIndex->append(fields->count());
+        lineCount++;
+
+        lineStart = pos + 1;
+        fieldStart = lineStart;
+    }
+};
+
+} // namespace
+
+CsvScanner::CsvScanner(char separator, bool combineSeparators)
+    : mSeparator(separator), mCombine(combineSeparators)
+{
+
+}
+
+const char* CsvScanner::scan(const char* begin, const char* end, int maxLines,
+                             QVector<ByteSpan>& fields,
+                             QVector<int>& lineFieldIndex)
+{
+    fields.resize(0);
+    lineFieldIndex.resize(0);
+    lineFieldIndex.append(0);
+
+    if ((begin >= end) || (maxLines <= 0)) { return begin; }
+
+    const MaskFunc masks = maskFunc(currentIsa());
+
+    LineState s;
+    s.lineStart = begin;
+    s.fieldStart = begin;
+    s.fields = &fields;
+    s.lineFieldIndex = &lineFieldIndex;
+    s.combine = mCombine;
+
+    // Inside a quoted field, carried across blocks
+    bool inQuotes = false;
+    // Closing quote of the last quoted field, to recognise a doubled quote
+    const char* quoteEnd = nullptr;
+    // Last partial block is copied to a zero-padded buffer so the SIMD loads
+    // don't read past the end.
+    char tail[blockSize];
+
+    for (const char* p = begin; p < end; p += blockSize) {
+
+        const char* block = p;
+        qint64 len = end - p;
+        if (len < blockSize) {
+            memset(tail, 0, blockSize);
+            memcpy(tail, p, len);
+            block = tail;
+        }
+
+        Masks m = masks(block, mSeparator);
+
+        // Quotes are handled in order with the separators and newlines, as
+        // whether a quote counts depends on where the field starts: a quote
+        // only opens a quoted field as the first byte of a field, and other
+        // quotes outside quoted fields are literal text (e.g. 12" pipe).
+        // Inside a quoted field, a quote closes it, unless followed by
+        // another quote (an escaped quote), which opens it again.
+        quint64 structural = m.separator | m.newline | m.quote;
+
+        while (structural) {
+            int i = qCountTrailingZeroBits(structural);
+            structural &= structural - 1;
+            const char* pos = p + i;
+            if ((m.newline >> i) & 1) {
+                // A newline always ends the line, also inside quotes
+                inQuotes = false;
+                s.newline(pos);
+                if (s.lineCount == maxLines) {
+                    return s.lineStart;
+                }
+            } else if ((m.quote >> i) & 1) {
+                if (inQuotes) {
+                    inQuotes = false;
+                    quoteEnd = pos;
+                } else if ((pos == s.fieldStart) || (pos - 1 == quoteEnd)) {
+                    inQuotes = true;
+                }
+            } else if (!inQuotes) {
+                s.separator(pos);
+            }
+        }
+    }
+
+    // Last line without newline
+    if (s.lineStart < end) {
+        s.newline(end);
+    }
+
+    return end;
+}
+
+void CsvScanner::scanLine(const char* begin, const char* end,
+                          QVector<ByteSpan>& fields)
+{
+    scan(begin, end, 1, fields, mLineFieldIndex);
+    if (mLineFieldIndex.count() < 2) {
+        // Empty line still results in one empty field
+        fields.append(ByteSpan(begin, 0));
+    }
+}
+
+CsvScanner::Isa CsvScanner::isa()
+{
+    return currentIsa();
+}
+
+QString CsvScanner::isaName(Isa isa)
+{
+    switch (isa) {
+    case IsaAvx2:
+        return "AVX2";
+    case IsaSse2:
+        return "SSE2";
+    default:
+        return "Scalar";
+    }
+}
+
+void CsvScanner::setIsa(Isa isa)
+{
+    Isa best = bestIsa();
+    if ((isa == IsaAvx2) && (best != IsaAvx2)) {
+        isa = best;
+    } else if ((isa == IsaSse2) && (best == IsaScalar)) {
+        isa = best;
+    }
+    currentIsa() = isa;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef CSVSCANNER_H
+#define CSVSCANNER_H
+
+#include "ByteSpan.h"
+
+#include <QString>
+#include <QVector>
+
+/* CsvScanner splits CSV text into fields, many lines at a time.
+ *
+ * The text is processed in blocks of 64 bytes. For each block, bitmasks of
+ * separator, newline and quote positions are built with SIMD compares (AVX2
+ * or SSE2, chosen at runtime, with a scalar fallback). The set bits are
+ * walked in order to emit the fields.
+ *
+ * - A field is quoted if its first byte is a double quote. Separators inside
+ *   a quoted field do not split it, and doubled quotes ("") in it stand for
+ *   one quote. Quotes elsewhere are literal text, e.g. 12" or 5'11".
+ * - Quotes surrounding a field are removed from the resulting span. Doubled
+ *   quotes are left in the span, which is then marked with
+ *   ByteSpan::escapedQuotes so they are undone when the text is copied.
+ * - A newline always ends a line, even inside quotes. Multi-line fields are
+ *   not supported as the rest of the import works line by line.
+ * - A carriage return before a newline is not part of the last field.
+ * - When combining separators, leading, trailing and contiguous separators
+ *   do not result in empty fields. A line without data still results in a
+ *   single empty field. */
+
+class CsvScanner
+{
+public:
+    CsvScanner(char separator, bool combineSeparators);
+
+    /* Scan up to maxLines lines from [begin, end). The fields of all lines
+     * are stored in fields, and lineFieldIndex gets the index of the first
+     * field of each line, plus a final entry with the total field count, so
+     * line i has fields [lineFieldIndex[i], lineFieldIndex[i+1]).
+     * Both vectors are cleared first, but keep their capacity.
+     * Returns the start of the next unscanned line (end if all was scanned).
+     * If end is not preceded by a newline, the text up to end is taken as the
+     * last line. */
+    const char* scan(const char* begin, const char* end, int maxLines,
+                     QVector<ByteSpan>& fields, QVector<int>& lineFieldIndex);
+
+    // Scan a single line, which should not include the newline
+    void scanLine(const char* begin, const char* end, QVector<ByteSpan>& fields);
+
+    enum Isa { IsaScalar, IsaSse2, IsaAvx2 };
+    static Isa isa();
+    static QString isaName(Isa isa);
+    // Override the automatically detected instruction set, e.g. for
+    // benchmarking. Falls back to a supported one if not available.
+    static void setIsa(Isa isa);
+
+private:
+    char mSeparator;
+    bool mCombine;
+
+    QVector<int> mLineFieldIndex;
+};
+
+#endif // CSVSCANNER_H
@@ -0,0 +1,368 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "CsvSource.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+
+QSharedPointer<CsvSource> CsvSource::open(const Csv::FileInfo& fileInfo,
+                                          ProgressCallback progress,
+                                          QString& error)
+{
+    QSharedPointer<CsvSource> source(new CsvSource());
+    source->mFileInfo = fileInfo;
+    source->mFile.reset(new QFile(fileInfo.filename));
+    QFile& file = *source->mFile;
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return QSharedPointer<CsvSource>();
+    }
+    source->mSize = file.size();
+    if (source->mSize > 0) {
+        uchar* data = file.map(0, source->mSize);
+        if (!data) {
+            error = file.errorString();
+            return QSharedPointer<CsvSource>();
+        }
+        source->mData = reinterpret_cast<const char*>(data);
+    }
+
+    const char* data = source->mData;
+    const char* end = data + source->mSize;
+
+    // Skip to start of data
+    const char* dataStart = data;
+    for (int lineNum = 0; lineNum < fileInfo.dataStartRow; lineNum++) {
+        if (dataStart >= end) { break; }
+        Csv::findLineEnd(dataStart, end, &dataStart);
+    }
+    source->mColumnCount = fileInfo.headings.count();
+    if (dataStart >= end) {
+        // No data
+        return source;
+    }
+
+    // Date and time, and category columns, from the first data rows
+    {
+        CsvScanner scanner(fileInfo.separator, fileInfo.combineSeparators);
+        QVector<ByteSpan> fields;
+        const char* pos = dataStart;
+        Matrix::ColumnSample columnSample;
+        while ((pos < end) && !columnSample.isFull()) {
+            source->lineFields(scanner, pos, fields);
+            columnSample.addLine(fields);
+        }
+        source->mTimeColumns = columnSample.timeColumns(fileInfo.headings);
+        source->mCategoryColumns = columnSample.categoryColumns();
+    }
+
+    // Split into chunks at line boundaries, the same as for a mapped import
+    qint64 dataSize = end - dataStart;
+    int chunkCount = qBound<qint64>(1, dataSize / minChunkSize,
+                                    QThread::idealThreadCount() * 4);
+    QVector<IndexJob> jobs(chunkCount);
+    const char* chunkStart = dataStart;
+    for (int i = 0; i < chunkCount; i++) {
+        IndexJob& job = jobs[i];
+        job.begin = chunkStart;
+        if (i == chunkCount - 1) {
+            job.end = end;
+        } else {
+            const char* splitPos = dataStart + (dataSize * (i + 1)) / chunkCount;
+            splitPos = qMax(splitPos, chunkStart);
+            Csv::findLineEnd(splitPos, end, &job.end);
+        }
+        chunkStart = job.end;
+    }
+
+    QAtomicInteger<qint64> bytesIndexed(0);
+    QAtomicInt stop(0);
+    const CsvSource* constSource = source.data();
+    for (int i = 0; i < chunkCount; i++) {
+        IndexJob* job = &jobs[i];
+        job->future = QtConcurrent::run([constSource, job, &bytesIndexed, &stop]()
+        {
+            constSource->indexChunk(job, &bytesIndexed, &stop);
+        });
+    }
+
+    // Merge chunks in order
+    QElapsedTimer progressFeedbackTimer;
+    progressFeedbackTimer.start();
+    for (int i = 0; i < chunkCount; i++) {
+        IndexJob& job = jobs[i];
+        while (!job.future.isFinished()) {
+            QThread::msleep(10);
+            if (progress && (progressFeedbackTimer.elapsed() > 100)) {
+                progressFeedbackTimer.restart();
+                qint64 indexed = bytesIndexed.loadAcquire() + (dataStart - data);
+                if (!progress(indexed, source->mSize)) {
+                    stop.storeRelease(1);
+                }
+            }
+        }
+        if (stop.loadAcquire()) {
+            // The chunks still running use the stack
+            for (int j = i; j < chunkCount; j++) {
+                jobs[j].future.waitForFinished();
+            }
+            error = "Stopped";
+            return QSharedPointer<CsvSource>();
+        }
+
+        int firstRow = source->mRowCount;
+        if (qint64(firstRow) + job.lineCount >= std::numeric_limits<int>::max()) {
+            stop.storeRelease(1);
+            for (int j = i; j < chunkCount; j++) {
+                jobs[j].future.waitForFinished();
+            }
+            error = "Too many rows";
+            return QSharedPointer<CsvSource>();
+        }
+        foreach (const auto& widening, job.widenings) {
+            // Columns added by a line with more fields than the lines before
+            // it, backfilled up to that line. The columns of the first line
+            // are there from the start.
+            int row = firstRow + widening.first;
+            if (row == 0) {
+                source->mColumnCount = qMax(source->mColumnCount, widening.second);
+            }
+            while (source->mColumnCount < widening.second) {
+                source->mBackfilledRows.resize(source->mColumnCount);
+                source->mBackfilledRows.append(row);
+                source->mColumnCount++;
+            }
+        }
+        for (int j = 0; j < job.sampleLines.count(); j++) {
+            source->mSampleRows.append(firstRow + job.sampleLines[j]);
+        }
+        source->mSampleOffsets.append(job.sampleOffsets);
+        source->mRowCount += job.lineCount;
+    }
+    source->mBackfilledRows.resize(source->mColumnCount);
+
+    return source;
+}
+
+void CsvSource::indexChunk(IndexJob* job, QAtomicInteger<qint64>* bytesIndexed,
+                           const QAtomicInt* stop) const
+{
+    CsvScanner scanner(mFileInfo.separator, mFileInfo.combineSeparators);
+    QVector<ByteSpan> fields;
+    QVector<int> lineFieldIndex;
+    int maxFieldCount = 0;
+
+    const char* pos = job->begin;
+    while (pos < job->end) {
+        if (stop->loadAcquire()) { return; }
+        const char* blockStart = pos;
+        pos = scanner.scan(pos, job->end, 256, fields, lineFieldIndex);
+        int lines = lineFieldIndex.count() - 1;
+        // The scanner ends lines at every newline, so the line starts are
+        // those after the newlines. Only needed for the samples.
+        const char* line = blockStart;
+        int lineInBlock = 0;
+        for (int i = 0; i < lines; i++) {
+            int lineNum = job->lineCount + i;
+            if ((lineNum % sampleInterval) == 0) {
+                for (; lineInBlock < i; lineInBlock++) {
+                    Csv::findLineEnd(line, pos, &line);
+                }
+                job->sampleLines.append(lineNum);
+                job->sampleOffsets.append(line - mData);
+            }
+            int fieldCount = lineFieldIndex[i + 1] - lineFieldIndex[i];
+            if (fieldCount > maxFieldCount) {
+                maxFieldCount = fieldCount;
+                job->widenings.append(qMakePair(lineNum, fieldCount));
+            }
+        }
+        job->lineCount += lines;
+        bytesIndexed->fetchAndAddRelaxed(pos - blockStart);
+    }
+}
+
+const char* CsvSource::lineStart(int row) const
+{
+    // Last sample at or before the row
+    int i = int(std::upper_bound(mSampleRows.cbegin(), mSampleRows.cend(), row)
+                - mSampleRows.cbegin()) - 1;
+    const char* line = mData + mSampleOffsets[i];
+    const char* end = mData + mSize;
+    for (int skip = row - mSampleRows[i]; skip > 0; skip--) {
+        Csv::findLineEnd(line, end, &line);
+    }
+    return line;
+}
+
+int CsvSource::rowCount() const
+{
+    return mRowCount;
+}
+
+int CsvSource::columnCount() const
+{
+    return mColumnCount;
+}
+
+QStringList CsvSource::headings() const
+{
+    return mFileInfo.headings;
+}
+
+Column::Type CsvSource::columnType(int /*col*/) const
+{
+    // Not known until read. Widened as values are stored.
+    return Column::TypeBool;
+}
+
+int CsvSource::backfilledRows(int col) const
+{
+    return mBackfilledRows.value(col);
+}
+
+bool CsvSource::isTimeColumn(int col) const
+{
+    return mTimeColumns.value(col);
+}
+
+bool CsvSource::isCategoryColumn(int col) const
+{
+    return mCategoryColumns.value(col);
+}
+
+int CsvSource::blockCount() const
+{
+    return (rowCount() + blockRows - 1) / blockRows;
+}
+
+int CsvSource::blockStart(int block) const
+{
+    return qMin(qint64(block) * blockRows, qint64(rowCount()));
+}
+
+bool CsvSource::readBlock(int col, int block, QVector<double>& values,
+                          QVector<Error>& errors, QString& error)
+{
+    QVector<QVector<double>> colValues;
+    QVector<QVector<Error>> colErrors;
+    if (!readColumnsBlock({col}, block, colValues, colErrors, error)) {
+        return false;
+    }
+    values = colValues.first();
+    errors = colErrors.first();
+    return true;
+}
+
+bool CsvSource::readColumnsBlock(const QVector<int>& cols, int block,
+                                 QVector<QVector<double>>& values,
+                                 QVector<QVector<Error>>& errors,
+                                 QString& error)
+{
+    int first = blockStart(block);
+    return readRows(cols, first, blockStart(block + 1) - first, values, errors,
+                    error);
+}
+
+bool CsvSource::readRows(const QVector<int>& cols, int first, int count,
+                         QVector<QVector<double>>& values,
+                         QVector<QVector<Error>>& errors, QString& error)
+{
+    int end = first + count;
+    if ((first < 0) || (count <= 0) || (end > rowCount())) {
+        error = "Rows out of range";
+        return false;
+    }
+
+    CsvScanner scanner(mFileInfo.separator, mFileInfo.combineSeparators);
+    QVector<ByteSpan> fields;
+
+    values.fill(QVector<double>(count), cols.count());
+    errors.fill(QVector<Error>(), cols.count());
+
+    // Rows before a column was added get the value of the row that added it
+    QVector<double> backfillValues(cols.count());
+    for (int i = 0; i < cols.count(); i++) {
+        int backfilled = backfilledRows(cols[i]);
+        if (first < backfilled) {
+            const char* line = lineStart(backfilled);
+            lineFields(scanner, line, fields);
+            bool ok;
+            bool timestamp;
+            double value = Matrix::convertValue(fields.value(cols[i]), &ok,
+                                                &timestamp);
+            if (timestamp && !isTimeColumn(cols[i])) { ok = false; }
+            backfillValues[i] = ok ? value : 0;
+        }
+    }
+
+    const char* line = lineStart(first);
+    for (int row = first; row < end; row++) {
+        lineFields(scanner, line, fields);
+        for (int i = 0; i < cols.count(); i++) {
+            int col = cols[i];
+            int backfilled = backfilledRows(col);
+            double& value = values[i][row - first];
+            Error e;
+            e.row = row - first;
+            if (row < backfilled) {
+                // Errors implied by the matrix's backfilled rows
+                value = backfillValues[i];
+            } else if (col >= fields.count()) {
+                e.type = Error::MissingField;
+                errors[i].append(e);
+            } else if (isCategoryColumn(col)) {
+                // Category columns are never backfilled, being in the first row
+                e.type = Error::Category;
+                e.text = fields[col].toByteArray();
+                errors[i].append(e);
+            } else {
+                bool ok;
+                bool timestamp;
+                value = Matrix::convertValue(fields[col], &ok, &timestamp);
+                if (timestamp && !isTimeColumn(col)) { ok = false; }
+                if ((backfilled > 0) && (row == backfilled)) {
+                    if (!ok) { value = 0; }
+                    e.type = Error::ExcessField;
+                    errors[i].append(e);
+                } else if (!ok) {
+                    e.type = Error::ConversionError;
+                    e.text = fields[col].toByteArray();
+                    errors[i].append(e);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void CsvSource::lineFields(CsvScanner& scanner, const char*& pos,
+                           QVector<ByteSpan>& fields) const
+{
+    const char* line = pos;
+    const char* lineEnd = Csv::findLineEnd(line, mData + mSize, &pos);
+    scanner.scanLine(line, lineEnd, fields);
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef CSVSOURCE_H
+#define CSVSOURCE_H
+
+#include "ColumnSource.h"
+#include "csv.h"
+#include "CsvScanner.h"
+
+#include <QAtomicInteger>
+#include <QFile>
+#include <QFuture>
+#include <QSharedPointer>
+
+#include <functional>
+
+/* CsvSource reads columns of a memory-mapped CSV file on demand (see
+ * Matrix::setSource()), so a file can be opened without converting the
+ * fields of all its columns, most of which are typically never plotted.
+ *
+ * Opening indexes the file in parallel chunks: the start of each line and
+ * the number of fields in it, which gives the row and column counts and the
+ * rows from which columns were added by longer lines. Only the start of
+ * every 64th line is kept, which is enough to seek to any row by skipping
+ * the few lines after it, so the index takes a fraction of a byte per row.
+ * When columns are read, the lines are split into fields again and all
+ * columns requested are converted in the same pass. Errors are reported the
+ * same as when importing all rows. */
+
+class CsvSource : public ColumnSource
+{
+public:
+    // Returns false to stop indexing
+    typedef std::function<bool(qint64 bytesIndexed, qint64 size)> ProgressCallback;
+    // Returns null with error set if the file can't be opened or mapped, or
+    // indexing was stopped. progress is called now and then while indexing.
+    static QSharedPointer<CsvSource> open(const Csv::FileInfo& fileInfo,
+                                          ProgressCallback progress,
+                                          QString& error);
+
+    int rowCount() const override;
+    int columnCount() const override;
+    QStringList headings() const override;
+    Column::Type columnType(int col) const override;
+    int backfilledRows(int col) const override;
+    bool isTimeColumn(int col) const override;
+    bool isCategoryColumn(int col) const override;
+    int blockCount() const override;
+    int blockStart(int block) const override;
+    bool isThreadSafe() const override { return true; }
+    bool hasRowAccess() const override { return true; }
+    bool readBlock(int col, int block, QVector<double>& values,
+                   QVector<Error>& errors, QString& error) override;
+    bool readColumnsBlock(const QVector<int>& cols, int block,
+                          QVector<QVector<double>>& values,
+                          QVector<QVector<Error>>& errors,
+                          QString& error) override;
+    bool readRows(const QVector<int>& cols, int first, int count,
+                  QVector<QVector<double>>& values,
+                  QVector<QVector<Error>>& errors, QString& error) override;
+
+private:
+    CsvSource() {}
+
+    Csv::FileInfo mFileInfo;
+    // Kept open as the mapping is only valid as long as the file is
+    QSharedPointer<QFile> mFile;
+    const char* mData = nullptr;
+    qint64 mSize = 0;
+
+    int mRowCount = 0;
+    // Sampled line index: rows and the offsets of their starts, in row order.
+    // The first row of each indexing chunk and every sampleInterval-th row
+    // after it.
+    QVector<int> mSampleRows;
+    QVector<qint64> mSampleOffsets;
+    static const int sampleInterval = 64;
+    // Start of a data row
+    const char* lineStart(int row) const;
+    int mColumnCount = 0;
+    QVector<int> mBackfilledRows;
+    // Columns mostly of dates or times in the first data rows, or with a
+    // time heading (see Matrix::ColumnSample)
+    QVector<bool> mTimeColumns;
+    // Columns (almost) only of text in the first data rows (see
+    // Matrix::ColumnSample)
+    QVector<bool> mCategoryColumns;
+
+    // Rows per block when reading columns. Blocks are read in parallel.
+    static const int blockRows = 16384;
+
+    struct IndexJob
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        int lineCount = 0;
+        // Line in chunk, offset of its start
+        QVector<int> sampleLines;
+        QVector<qint64> sampleOffsets;
+        // Lines with more fields than the lines before them in the chunk:
+        // line in chunk, field count
+        QVector<QPair<int, int>> widenings;
+        QFuture<void> future;
+    };
+    static const qint64 minChunkSize = 1024 * 1024;
+    void indexChunk(IndexJob* job, QAtomicInteger<qint64>* bytesIndexed,
+                    const QAtomicInt* stop) const;
+
+    // Fields of the line at pos, which point into the mapped file. Sets pos
+    // to the start of the next line.
+    void lineFields(CsvScanner& scanner, const char*& pos,
+                    QVector<ByteSpan>& fields) const;
+};
+typedef QSharedPointer<CsvSource> CsvSourcePtr;
+
+#endif // CSVSOURCE_H
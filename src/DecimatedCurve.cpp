@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "DecimatedCurve.h"
+
+DecimatedCurve::DecimatedCurve(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    : QCPCurve(keyAxis, valueAxis)
+{
+
+}
+
+void DecimatedCurve::decimate(const QVector<QPointF> &points,
+                              double maxDeviation, QVector<QPointF> &out)
+{
+    const double maxDistSqr = maxDeviation * maxDeviation;
+    const QPointF* p = points.constData();
+    int count = points.count();
+
+    bool haveLast = false;
+    QPointF last;
+    for (int i = 0; i < count; i++) {
+        const QPointF& point = p[i];
+        if (qIsNaN(point.x()) || qIsNaN(point.y())) {
+            // Gap in the line
+            out.append(point);
+            haveLast = false;
+            continue;
+        }
+        if (haveLast && (i < count - 1)) {
+            double dx = point.x() - last.x();
+            double dy = point.y() - last.y();
+            if (dx * dx + dy * dy <= maxDistSqr) { continue; }
+        }
+        out.append(point);
+        last = point;
+        haveLast = true;
+    }
+}
+
+void DecimatedCurve::drawCurveLine(QCPPainter *painter,
+                                   const QVector<QPointF> &lines) const
+{
+    if (painter->modes().testFlag(QCPPainter::pmVectorized)
+            || (lines.count() < 3)) {
+        QCPCurve::drawCurveLine(painter, lines);
+        return;
+    }
+
+    mDecimated.clear();
+    mDecimated.reserve(lines.count());
+    decimate(lines, maxDeviationPx, mDecimated);
+    QCPCurve::drawCurveLine(painter, mDecimated);
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef DECIMATEDCURVE_H
+#define DECIMATEDCURVE_H
+
+#include "QCustomPlot/qcustomplot.h"
+
+/* DecimatedCurve is a QCPCurve that leaves out segments too small to see
+ * when drawing. Unlike QCPGraph, QCPCurve draws a line to every point in the
+ * visible area, so with millions of points every pan and zoom redraws them
+ * all, mostly on top of each other.
+ *
+ * A point is only drawn if it is more than maxDeviationPx from the last point
+ * drawn. Every point left out is then within that distance of the line
+ * drawn, so the shape of the curve, including spikes, is kept. The number of
+ * segments drawn depends on the length of the curve in pixels instead of the
+ * number of points. Vector exports (e.g. SVG) are not decimated. */
+
+class DecimatedCurve : public QCPCurve
+{
+    Q_OBJECT
+public:
+    DecimatedCurve(QCPAxis* keyAxis, QCPAxis* valueAxis);
+
+    // Less than a pixel, so decimation can't be seen
+    double maxDeviationPx = 0.5;
+
+    // Append the points of a polyline to be drawn to out. Gaps (NaN points)
+    // and the last point are kept.
+    static void decimate(const QVector<QPointF>& points, double maxDeviation,
+                         QVector<QPointF>& out);
+
+protected:
+    void drawCurveLine(QCPPainter* painter,
+                       const QVector<QPointF>& lines) const override;
+
+private:
+    // Reused for every draw
+    mutable QVector<QPointF> mDecimated;
+};
+
+#endif // DECIMATEDCURVE_H
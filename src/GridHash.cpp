@@ -0,0 +1,257 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "GridHash.h"
+
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <cmath>
+
+int GridHash::resolution() const
+{
+    return mN;
+}
+
+int GridHash::maxcolrow() const
+{
+    return mN - 1;
+}
+
+QSizeF GridHash::cellSize() const
+{
+    return QSizeF(bounds.width() / mN, bounds.height() / mN);
+}
+
+int GridHash::hash(QPoint point) const
+{
+    return point.x() * mN + point.y();
+}
+
+int GridHash::toColRow(double value) const
+{
+    // NaN and values left of/above the grid give -1, values right of/below
+    // it mN, without overflowing the int
+    if (!(value >= 0)) { return -1; }
+    if (value >= mN) { return mN; }
+    return value;
+}
+
+QPoint GridHash::colrow(QPointF coord) const
+{
+    // Each axis is divided separately, so cells have the aspect ratio of the
+    // bounds. A bounds of zero width or height is a single column or row.
+    int col = 0;
+    if (bounds.width() > 0) {
+        col = toColRow((coord.x() - bounds.left()) / bounds.width() * mN);
+    }
+    int row = 0;
+    if (bounds.height() > 0) {
+        row = toColRow((coord.y() - bounds.top()) / bounds.height() * mN);
+    }
+
+    return QPoint(col, row);
+}
+
+int GridHash::clipcolrow(int value) const
+{
+    return (qMax(qMin(value, maxcolrow()), 0));
+}
+
+int GridHash::cell(QPointF coord) const
+{
+    QPoint point = colrow(coord);
+    return hash(QPoint(clipcolrow(point.x()), clipcolrow(point.y())));
+}
+
+int GridHash::chooseResolution(QRectF bounds, const QVector<QPointF>& coords)
+{
+    // Aim for this many points in each cell that has any, so that a lookup
+    // near the data scans few points, and the empty cells around it cost
+    // little as a column's cells are scanned in one go.
+    static const int pointsPerCell = 8;
+    static const int maxResolution = 2048;
+    // Occupied cells are counted in a grid of this resolution and one of
+    // half of it, over at most maxSamples points
+    static const int m = 64;
+    static const int maxSamples = 65536;
+
+    int count = coords.count();
+    if (count <= pointsPerCell) { return 1; }
+
+    QVector<bool> fine(m * m, false);
+    QVector<bool> coarse((m / 2) * (m / 2), false);
+    int fineCount = 0;
+    int coarseCount = 0;
+    int step = qMax(1, count / maxSamples);
+    for (int i = 0; i < count; i += step) {
+        const QPointF& p = coords[i];
+        double x = (bounds.width() > 0)
+                ? (p.x() - bounds.left()) / bounds.width() * m : 0;
+        double y = (bounds.height() > 0)
+                ? (p.y() - bounds.top()) / bounds.height() * m : 0;
+        // Skips NaN and points outside the bounds
+        if (!((x >= 0) && (x <= m) && (y >= 0) && (y <= m))) { continue; }
+        int col = qMin((int)x, m - 1);
+        int row = qMin((int)y, m - 1);
+
+        int c = col * m + row;
+        if (!fine[c]) {
+            fine[c] = true;
+            fineCount++;
+        }
+        c = (col / 2) * (m / 2) + row / 2;
+        if (!coarse[c]) {
+            coarse[c] = true;
+            coarseCount++;
+        }
+    }
+    if (fineCount == 0) { return 1; }
+
+    // Occupied cells grow with the resolution to the power d, the dimension
+    // of the points: 1 along a line and 2 spread over an area. Clusters are
+    // in between at this scale.
+    double d = qBound(1.0, std::log2(double(fineCount) / coarseCount), 2.0);
+
+    // Solve count / (fineCount * (n / m)^d) = pointsPerCell for n
+    double n = m * qPow(double(count) / (pointsPerCell * fineCount), 1.0 / d);
+
+    // Not more cells than points, which bounds the memory of the cell
+    // offsets to that of the point indexes
+    n = qMin(n, qSqrt(count));
+
+    return qBound(1, (int)n, maxResolution);
+}
+
+void GridHash::build(QRectF bounds, const QVector<QPointF>& coords,
+                     const QVector<int>& indexes)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    this->bounds = bounds;
+    mAppended.clear();
+    pack(coords, indexes);
+
+    mBuildTimeMs = timer.elapsed();
+}
+
+void GridHash::pack(const QVector<QPointF>& coords, const QVector<int>& indexes)
+{
+    mN = (n > 0) ? n : chooseResolution(bounds, coords);
+
+    // Counting sort of the points by cell. The indexes are the positions in
+    // coords if not specified.
+    int cellCount = mN * mN;
+    int count = coords.count();
+
+    QVector<int> cells(count);
+    QVector<int> starts(cellCount + 1, 0);
+    for (int i = 0; i < count; i++) {
+        int c = cell(coords[i]);
+        cells[i] = c;
+        starts[c + 1]++;
+    }
+    for (int c = 0; c < cellCount; c++) {
+        starts[c + 1] += starts[c];
+    }
+
+    QVector<int> next = starts;
+    mCoords.resize(count);
+    mIndexes.resize(count);
+    for (int i = 0; i < count; i++) {
+        int pos = next[cells[i]]++;
+        mCoords[pos] = coords[i];
+        mIndexes[pos] = indexes.isEmpty() ? i : indexes[i];
+    }
+    mCoords.squeeze();
+    mIndexes.squeeze();
+
+    mCellStarts = starts;
+}
+
+void GridHash::packAppended()
+{
+    QVector<QPointF> coords = mCoords;
+    QVector<int> indexes = mIndexes;
+    coords.reserve(coords.count() + mAppended.count());
+    indexes.reserve(indexes.count() + mAppended.count());
+
+    // Grow the bounds with the data so that appended points don't all end
+    // up in the edge cells
+    double left = bounds.left();
+    double right = bounds.right();
+    double top = bounds.top();
+    double bottom = bounds.bottom();
+    for (const Data& d : qAsConst(mAppended)) {
+        coords.append(d.coord);
+        indexes.append(d.index);
+        if (std::isfinite(d.coord.x()) && std::isfinite(d.coord.y())) {
+            left = qMin(left, d.coord.x());
+            right = qMax(right, d.coord.x());
+            top = qMin(top, d.coord.y());
+            bottom = qMax(bottom, d.coord.y());
+        }
+    }
+    bounds = QRectF(QPointF(left, top), QPointF(right, bottom));
+    mAppended.clear();
+    mAppended.squeeze();
+
+    pack(coords, indexes);
+}
+
+void GridHash::insert(QPointF coord, int index)
+{
+    mAppended.append(Data{coord, index});
+
+    // Keep the linear scan of the append buffer short compared to the cost
+    // of a lookup in the packed cells.
+    static const int minPackCount = 4096;
+    if (mAppended.count() >= qMax(minPackCount, mCoords.count() / 4)) {
+        packAppended();
+    }
+}
+
+void GridHash::clear()
+{
+    mCellStarts.clear();
+    mCoords.clear();
+    mIndexes.clear();
+    mAppended.clear();
+    mBuildTimeMs = 0;
+}
+
+int GridHash::count() const
+{
+    return mCoords.count() + mAppended.count();
+}
+
+qint64 GridHash::memoryUsage() const
+{
+    return (qint64)mCellStarts.capacity() * sizeof(int)
+            + (qint64)mCoords.capacity() * sizeof(QPointF)
+            + (qint64)mIndexes.capacity() * sizeof(int)
+            + (qint64)mAppended.capacity() * sizeof(Data);
+}
+
+qint64 GridHash::buildTimeMs() const
+{
+    return mBuildTimeMs;
+}
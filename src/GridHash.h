@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef GRIDHASH_H
+#define GRIDHASH_H
+
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector>
+
+enum ClosestOption { ClosestXOnly, ClosestXY };
+
+/* GridHash is a uniform grid over the data bounds used to find the points
+ * near the mouse. Points are packed per cell into contiguous arrays
+ * (compressed sparse rows): cellStarts[cell] is the offset of the cell's
+ * first point and cellStarts[cell + 1] one past its last. Cells are numbered
+ * column by column so that the cells of a column are adjacent, which makes
+ * a lookup one contiguous scan per column, however many of its cells are
+ * empty.
+ *
+ * The number of columns and rows is chosen from the points when built, to
+ * have a few points in each cell that has any: more cells for more points,
+ * and more for points along a line or in clusters than for points spread
+ * over the whole area, as they occupy fewer of the cells. See
+ * chooseResolution().
+ *
+ * Points inserted after build() are kept in an unsorted append buffer that is
+ * packed into the cells once it grows too large. Lookups do not allocate. */
+struct GridHash
+{
+    QRectF bounds;
+    // Columns and rows of the grid. If 0, build() chooses it from the points.
+    int n = 0;
+
+    int resolution() const;
+    int maxcolrow() const;
+    // Size of a cell in coordinates
+    QSizeF cellSize() const;
+
+    struct Data
+    {
+        QPointF coord;
+        int index = 0;
+    };
+
+    int hash(QPoint point) const;
+    QPoint colrow(QPointF coord) const;
+    int clipcolrow(int value) const;
+
+    // Replace the grid contents with the specified coordinates. The index of
+    // each is its position in coords if indexes is empty.
+    void build(QRectF bounds, const QVector<QPointF>& coords,
+               const QVector<int>& indexes = QVector<int>());
+    void insert(QPointF coord, int index);
+    void clear();
+
+    int count() const;
+    qint64 memoryUsage() const;
+    // Duration of the last full build in milliseconds
+    qint64 buildTimeMs() const;
+
+    // Call func(const QPointF& coord, int index) for every point in the cells
+    // covering rect. Returns true if the whole grid was covered (i.e. a larger
+    // rect will not return more points).
+    template<typename Func>
+    bool visit(QRectF rect, ClosestOption option, Func func) const;
+    // As visit(), but calls func(const QPointF* coords, const int* indexes,
+    // int count) for blocks of contiguous points
+    template<typename Func>
+    bool visitBlocks(QRectF rect, ClosestOption option, Func func) const;
+
+    // Columns and rows for a grid of coords in bounds
+    static int chooseResolution(QRectF bounds, const QVector<QPointF>& coords);
+
+private:
+    int mN = 1;
+    QVector<int> mCellStarts;
+    QVector<QPointF> mCoords;
+    QVector<int> mIndexes;
+    QVector<Data> mAppended;
+    qint64 mBuildTimeMs = 0;
+
+    int toColRow(double value) const;
+    int cell(QPointF coord) const;
+    void pack(const QVector<QPointF>& coords, const QVector<int>& indexes);
+    void packAppended();
+};
+
+template<typename Func>
+bool GridHash::visit(QRectF rect, ClosestOption option, Func func) const
+{
+    return visitBlocks(rect, option,
+                       [&](const QPointF* coords, const int* indexes, int count)
+    {
+        for (int i = 0; i < count; i++) {
+            func(coords[i], indexes[i]);
+        }
+    });
+}
+
+template<typename Func>
+bool GridHash::visitBlocks(QRectF rect, ClosestOption option, Func func) const
+{
+    QPoint start = colrow(rect.topLeft());
+    QPoint end = colrow(rect.bottomRight());
+
+    int colstart = clipcolrow(start.x());
+    int colend = clipcolrow(end.x());
+    int rowstart;
+    int rowend;
+    if (option == ClosestXOnly) {
+        rowstart = 0;
+        rowend = maxcolrow();
+    } else {
+        rowstart = clipcolrow(start.y());
+        rowend = clipcolrow(end.y());
+    }
+
+    if (!mCellStarts.isEmpty()) {
+        const int* starts = mCellStarts.constData();
+        const QPointF* coords = mCoords.constData();
+        const int* indexes = mIndexes.constData();
+        for (int col = colstart; col <= colend; col++) {
+            // Rows of a column are adjacent cells
+            int from = starts[hash(QPoint(col, rowstart))];
+            int to = starts[hash(QPoint(col, rowend)) + 1];
+            if (to > from) {
+                func(coords + from, indexes + from, to - from);
+            }
+        }
+    }
+
+    for (const Data& d : mAppended) {
+        QPoint p = colrow(d.coord);
+        int col = clipcolrow(p.x());
+        int row = clipcolrow(p.y());
+        if ((col >= colstart) && (col <= colend)
+                && (row >= rowstart) && (row <= rowend)) {
+            func(&d.coord, &d.index, 1);
+        }
+    }
+
+    return (colstart == 0) && (colend == maxcolrow())
+            && (rowstart == 0) && (rowend == maxcolrow());
+}
+
+#endif // GRIDHASH_H
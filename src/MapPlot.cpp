@@ -21,10 +21,21 @@
 #include "MapPlot.h"
 
 #include "QGVMapQGView.h"
+#include "QGVProjectionEPSG3857.h"
 
 #include <QLayout>
 #include <QtMath>
 
+namespace {
+
+ColumnView doublesView(const QVector<double>& values)
+{
+    return ColumnView(reinterpret_cast<const char*>(values.constData()),
+                      Column::TypeDouble, values.count());
+}
+
+} // namespace
+
 // Static members
 QNetworkAccessManager MapPlot::netAccMgr;
 QNetworkDiskCache MapPlot::netCache;
@@ -253,6 +264,7 @@ void MapPlot::plot(CsvPtr csv, int iloncol, int ilatcol, Range range)
     graph->iycol = ilatcol;
     graph->ixcol = iloncol;
     graph->range = range;
+    graph->followsRows = range.sameAs(csv->allRange());
     track->lats = csv->matrix->dataColumn(ilatcol, range.start, range.size());
     track->lons = csv->matrix->dataColumn(iloncol, range.start, range.size());
 
@@ -263,8 +275,8 @@ void MapPlot::plot(CsvPtr csv, int iloncol, int ilatcol, Range range)
         track->name = QString("%1 (%2)").arg(track->name).arg(range.name);
     }
 
-    graph->ystats = Matrix::vectorStats(track->lats);
-    graph->xstats = Matrix::vectorStats(track->lons);
+    graph->ystats = Matrix::vectorStats(doublesView(track->lats));
+    graph->xstats = Matrix::vectorStats(doublesView(track->lons));
 
     // Combine track mins/maxes with overall of all tracks
 
@@ -275,12 +287,19 @@ void MapPlot::plot(CsvPtr csv, int iloncol, int ilatcol, Range range)
     QRectF r = graph->dataBounds();
     QGV::GeoRect gr(pointToGeo(r.topLeft()), pointToGeo(r.bottomRight()));
     QRectF projBounds = mMapWidget->getProjection()->geoToProj(gr);
-    graph->grid.bounds = projBounds;
+    // Projecting every point is slow for large tracks, so it is done with
+    // the grid build, which may be on a worker thread. That uses its own
+    // projection object, the same as the map's.
+    QVector<QGV::GeoPos> geoPoints(track->lats.count());
     for (int i = 0; i < track->lats.count(); i++) {
-        QPointF projPoint = mMapWidget->getProjection()->geoToProj(
-                    QGV::GeoPos(track->lats[i], track->lons[i]));
-        graph->grid.insert(projPoint, i);
+        geoPoints[i] = QGV::GeoPos(track->lats[i], track->lons[i]);
     }
+    QSharedPointer<QGVProjection> projection(new QGVProjectionEPSG3857());
+    buildGrid(graph, projBounds, geoPoints.count(),
+              [geoPoints, projection](int i)
+    {
+        return projection->geoToProj(geoPoints[i]);
+    });
 
     // Create track on map
     track->pen = Graph::nextPen(mPenIndex++);
@@ -303,6 +322,15 @@ void MapPlot::plot(CsvPtr csv, int iloncol, int ilatcol, Range range)
         setDataTipGraph(graph);
     }
 
+    // Track views need updating whenever rows are appended to the CSV
+    connect(csv.data(), &Csv::rowsAppended,
+            this, [this, graphWkPtr = graph.toWeakRef()](int firstRow, int count)
+    {
+        GraphPtr graph(graphWkPtr);
+        if (!graph || !mGraphs.contains(graph)) { return; }
+        appendTrackRows(graph, firstRow, count);
+    });
+
     // Add to legend
     mLegend->addEntry(track->pen.color(), track->name);
     if (mGraphs.count() == 1) {
@@ -322,6 +350,51 @@ void MapPlot::plot(CsvPtr csv, int iloncol, int ilatcol, Range range)
     QMetaObject::invokeMethod(this, [=]() { resized(); }, Qt::QueuedConnection);
 }
 
+void MapPlot::appendTrackRows(GraphPtr graph, int firstRow, int count)
+{
+    MatrixPtr mat = graph->csv->matrix;
+    TrackPtr track = graph->track;
+    // Index in track of first new row
+    int from = firstRow - graph->range.start;
+    bool append = graph->followsRows && (from == track->lats.count());
+    if (append) {
+        graph->range.end = firstRow + count;
+    }
+
+    if (!append) { return; }
+
+    track->lats += mat->dataColumn(graph->iycol, firstRow, count);
+    track->lons += mat->dataColumn(graph->ixcol, firstRow, count);
+
+    Matrix::extendVectorStats(graph->ystats, doublesView(track->lats), from);
+    Matrix::extendVectorStats(graph->xstats, doublesView(track->lons), from);
+    expandBounds(graph->dataBounds());
+
+    // Points outside the grid's bounds end up in the edge cells, where they
+    // are still found.
+    for (int i = from; i < track->lats.count(); i++) {
+        QPointF projPoint = mMapWidget->getProjection()->geoToProj(
+                    QGV::GeoPos(track->lats[i], track->lons[i]));
+        insertGridPoint(graph, projPoint, i);
+    }
+
+    // Add a line for the new points, continuing from the last one
+    QList<QGV::GeoPos> posList;
+    QGV::GeoPos lastPos;
+    for (int i = qMax(0, from - 1); i < track->lats.count(); i++) {
+        QGV::GeoPos pos = QGV::GeoPos(track->lats[i], track->lons[i]);
+        if (!posList.isEmpty() && (pos == lastPos)) { continue; }
+        posList.append(pos);
+        lastPos = pos;
+    }
+    if (posList.count() > 1) {
+        QGVLine* line = new QGVLine(posList);
+        line->setColor(track->pen.color());
+        track->mapLines.append(line);
+        mMapWidget->addItem(line);
+    }
+}
+
 void MapPlot::showEmpty()
 {
     // Call resized() to update crosshairs widget size. Queue it to give MapPlot
@@ -548,6 +621,23 @@ QPoint MapPlot::coordToPixelPos(QPointF coord)
     return mMapWidget->mapFromProj(coord);
 }
 
+bool MapPlot::linearPixelMap(ClosestKernel::PixelMap& map)
+{
+    // As QGVMap::mapFromProj(): the view's scene to viewport transform,
+    // followed by the view's position in the map widget
+    QTransform t = mMapWidget->geoView()->viewportTransform();
+    if (!t.isAffine()) { return false; }
+    QPoint viewPos = mMapWidget->geoView()->pos();
+
+    map.xx = t.m11();
+    map.xy = t.m21();
+    map.dx = t.dx() + viewPos.x();
+    map.yx = t.m12();
+    map.yy = t.m22();
+    map.dy = t.dy() + viewPos.y();
+    return true;
+}
+
 QPointF MapPlot::latLonToPoint(double lat, double lon)
 {
     return QPointF(lon, lat);
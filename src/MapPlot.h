@@ -109,6 +109,8 @@ private:
     void setupLink();
 
     void setDataTipGraph(GraphPtr graph);
+    // Update track for rows appended to its CSV (follow mode)
+    void appendTrackRows(GraphPtr graph, int firstRow, int count);
 
     // -----------------------------------------------------------------------
     // Legend
@@ -184,6 +186,7 @@ private:
 
     QPointF pixelPosToCoord(QPoint pos);
     QPoint coordToPixelPos(QPointF coord);
+    bool linearPixelMap(ClosestKernel::PixelMap& map);
 
     QPointF latLonToPoint(double lat, double lon);
     QGV::GeoPos pointToGeo(QPointF pos);
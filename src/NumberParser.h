@@ -0,0 +1,47 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef NUMBERPARSER_H
+#define NUMBERPARSER_H
+
+/* NumberParser converts text to numbers directly from a range of bytes,
+ * without allocating and independent of the locale.
+ *
+ * toDouble() accepts the same input as QByteArray::toDouble(): optional
+ * leading and trailing whitespace, an optional sign, decimal digits with an
+ * optional decimal point and exponent, and inf/nan. It is correctly rounded.
+ * Numbers with up to 19 significant digits (i.e. practically all) are
+ * converted with the Eisel-Lemire algorithm, using a table of 128-bit powers
+ * of five, as done by the fast_float library. Longer ones fall back to
+ * QByteArray::toDouble().
+ *
+ * toBool() accepts true/false/1/0 (case insensitive) and an empty string as
+ * false, ignoring leading and trailing whitespace. */
+
+class NumberParser
+{
+public:
+    static bool toDouble(const char* begin, const char* end, double* value);
+    static bool toBool(const char* begin, const char* end, bool* value);
+
+    static void trim(const char** begin, const char** end);
+};
+
+#endif // NUMBERPARSER_H
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "ProcessMemory.h"
+
+#if defined(Q_OS_WIN)
+    #include <windows.h>
+    #include <psapi.h>
+#elif defined(Q_OS_LINUX)
+    #include <QFile>
+#elif defined(Q_OS_UNIX)
+    #include <sys/resource.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// Read a "Name:   1234 kB" field from /proc/self/status
+qint64 procStatusBytes(const char* name)
+{
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) { return -1; }
+    QByteArray prefix = QByteArray(name) + ":";
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.startsWith(prefix)) { continue; }
+        QList<QByteArray> parts = line.mid(prefix.size()).simplified().split(' ');
+        bool ok;
+        qint64 kb = parts.value(0).toLongLong(&ok);
+        return ok ? kb * 1024 : -1;
+    }
+    return -1;
+}
+#endif
+
+} // namespace
+
+qint64 ProcessMemory::current()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return counters.WorkingSetSize;
+#elif defined(Q_OS_LINUX)
+    return procStatusBytes("VmRSS");
+#else
+    return -1;
+#endif
+}
+
+qint64 ProcessMemory::peak()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return counters.PeakWorkingSetSize;
+#elif defined(Q_OS_LINUX)
+    return procStatusBytes("VmHWM");
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return -1; }
+  #ifdef Q_OS_MACOS
+    return usage.ru_maxrss; // Bytes
+  #else
+    return qint64(usage.ru_maxrss) * 1024; // Kilobytes
+  #endif
+#else
+    return -1;
+#endif
+}
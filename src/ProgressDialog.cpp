@@ -26,6 +26,7 @@ ProgressDialog::ProgressDialog(QWidget *parent) :
     ui(new Ui::ProgressDialog)
 {
     ui->setupUi(this);
+    setCancelable(false);
 }
 
 ProgressDialog::~ProgressDialog()
@@ -48,6 +49,19 @@ void ProgressDialog::preventClose(bool prevent)
     mPreventClose = prevent;
 }
 
+void ProgressDialog::setCancelable(bool cancelable)
+{
+    ui->pushButton_cancel->setVisible(cancelable);
+    ui->pushButton_cancel->setEnabled(true);
+}
+
+void ProgressDialog::on_pushButton_cancel_clicked()
+{
+    // Until it is done
+    ui->pushButton_cancel->setEnabled(false);
+    emit cancelClicked();
+}
+
 void ProgressDialog::closeEvent(QCloseEvent* event)
 {
     if (mPreventClose) { event->ignore(); }
@@ -39,6 +39,14 @@ public:
     void setTitle(QString title);
     void setInfo(QString info);
     void preventClose(bool prevent);
+    // Show a cancel button, which emits cancelClicked()
+    void setCancelable(bool cancelable);
+
+signals:
+    void cancelClicked();
+
+private slots:
+    void on_pushButton_cancel_clicked();
 
 private:
     Ui::ProgressDialog *ui;
@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "PyramidGraph.h"
+
+PyramidGraph::PyramidGraph(QCPAxis *keyAxis, QCPAxis *valueAxis)
+    : QCPGraph(keyAxis, valueAxis)
+{
+
+}
+
+void PyramidGraph::updatePyramid()
+{
+    const QCPGraphDataContainer& data = *mDataContainer;
+    int count = data.size();
+
+    // Level 0 from the data
+    if (mLevels.isEmpty()) {
+        mLevels.append(QVector<Bucket>());
+    }
+    QVector<Bucket>& base = mLevels[0];
+    int bucketCount = count / baseBucketSize;
+    base.reserve(bucketCount);
+    for (int b = base.count(); b < bucketCount; b++) {
+        QCPGraphDataContainer::const_iterator it = data.constBegin()
+                + b * baseBucketSize;
+        Bucket bucket;
+        bucket.first = it->value;
+        bucket.min = it->value;
+        bucket.max = it->value;
+        for (int i = 1; i < baseBucketSize; i++) {
+            double value = (it + i)->value;
+            if (value < bucket.min) { bucket.min = value; }
+            if (value > bucket.max) { bucket.max = value; }
+        }
+        bucket.last = (it + baseBucketSize - 1)->value;
+        base.append(bucket);
+    }
+
+    // Each next level from the one below, while it has at least two buckets
+    for (int level = 1; mLevels[level - 1].count() >= 4; level++) {
+        if (mLevels.count() <= level) {
+            mLevels.append(QVector<Bucket>());
+        }
+        const QVector<Bucket>& below = mLevels[level - 1];
+        QVector<Bucket>& buckets = mLevels[level];
+        for (int b = buckets.count(); b < below.count() / 2; b++) {
+            buckets.append(combine(below[2 * b], below[2 * b + 1]));
+        }
+    }
+}
+
+void PyramidGraph::clearPyramid()
+{
+    mLevels.clear();
+}
+
+qint64 PyramidGraph::pyramidMemoryUsage() const
+{
+    qint64 ret = 0;
+    foreach (const QVector<Bucket>& buckets, mLevels) {
+        ret += qint64(buckets.capacity()) * sizeof(Bucket);
+    }
+    return ret;
+}
+
+PyramidGraph::Bucket PyramidGraph::combine(const Bucket &a, const Bucket &b)
+{
+    Bucket ret;
+    ret.first = a.first;
+    ret.last = b.last;
+    ret.min = qMin(a.min, b.min);
+    ret.max = qMax(a.max, b.max);
+    return ret;
+}
+
+void PyramidGraph::getOptimizedLineData(
+        QVector<QCPGraphData> *lineData,
+        const QCPGraphDataContainer::const_iterator &begin,
+        const QCPGraphDataContainer::const_iterator &end) const
+{
+    QCPAxis* keyAxis = mKeyAxis.data();
+    // Pixels are only evenly spaced in keys on a linear axis. A pyramid
+    // covering more points than there are is out of date.
+    if (!lineData || !keyAxis || mLevels.isEmpty() || !mAdaptiveSampling
+            || (keyAxis->scaleType() != QCPAxis::stLinear)
+            || (mLevels[0].count() * baseBucketSize > mDataContainer->size())
+            || (begin == end)) {
+        QCPGraph::getOptimizedLineData(lineData, begin, end);
+        return;
+    }
+
+    int first = int(begin - mDataContainer->constBegin());
+    int last = int(end - mDataContainer->constBegin());
+    double pixelSpan = qAbs(keyAxis->coordToPixel(begin->key)
+                            - keyAxis->coordToPixel((end - 1)->key));
+    double pointsPerPixel = (last - first) / qMax(1.0, pixelSpan);
+
+    // Largest buckets with at least two per pixel
+    int level = -1;
+    while ((level + 1 < mLevels.count())
+           && ((baseBucketSize << (level + 1)) * 2 <= pointsPerPixel)) {
+        level++;
+    }
+    if (level < 0) {
+        QCPGraph::getOptimizedLineData(lineData, begin, end);
+        return;
+    }
+
+    lineData->clear();
+    lineData->reserve(4 * ((last - first) / (baseBucketSize << level)
+                           + 2 * (level + 1)) + 2 * baseBucketSize);
+    QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+
+    // Walk the range with the largest buckets that fit, up to the chosen
+    // level. Only the partial buckets at the edges use smaller ones, at most
+    // one per level on each side, down to single points for less than a
+    // level 0 bucket (and points not in the pyramid yet).
+    int i = first;
+    while (i < last) {
+        int bucketLevel = level;
+        int bucketSize = baseBucketSize << bucketLevel;
+        while ((bucketLevel >= 0)
+               && (((i % bucketSize) != 0) || (i + bucketSize > last)
+                   || (i / bucketSize >= mLevels[bucketLevel].count()))) {
+            bucketLevel--;
+            bucketSize /= 2;
+        }
+        if (bucketLevel < 0) {
+            lineData->append(*(dataBegin + i));
+            i++;
+            continue;
+        }
+        const Bucket& bucket = mLevels[bucketLevel][i / bucketSize];
+        double firstKey = (dataBegin + i)->key;
+        double lastKey = (dataBegin + i + bucketSize - 1)->key;
+        double midKey = (firstKey + lastKey) / 2;
+        lineData->append(QCPGraphData(firstKey, bucket.first));
+        lineData->append(QCPGraphData(midKey, bucket.min));
+        lineData->append(QCPGraphData(midKey, bucket.max));
+        lineData->append(QCPGraphData(lastKey, bucket.last));
+        i += bucketSize;
+    }
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#ifndef PYRAMIDGRAPH_H
+#define PYRAMIDGRAPH_H
+
+#include "QCustomPlot/qcustomplot.h"
+
+/* PyramidGraph is a QCPGraph that draws large data sets from a precomputed
+ * min/max pyramid instead of visiting every visible point. QCPGraph's
+ * adaptive sampling reduces the points drawn to a few per pixel, but still
+ * has to look at all the points in the visible key range on every replot.
+ *
+ * Level 0 of the pyramid holds the first, last, min and max value of each
+ * bucket of baseBucketSize consecutive points, and each next level combines
+ * two buckets of the level below. When drawing, the level with the largest
+ * buckets that still has at least two buckets per pixel is used, and each
+ * bucket is drawn as its first, min, max and last value, which keeps the
+ * envelope of the data. The cost of a replot then depends on the plot width
+ * instead of the number of points. The partial buckets at the edges of the
+ * visible range are drawn with the smaller buckets of lower levels. Only
+ * full buckets are in the pyramid; the points after the last one are drawn
+ * as they are, and when there are only a few points per pixel, all points
+ * are drawn the usual way.
+ *
+ * updatePyramid() has to be called after the data is set or added to. Only
+ * appending is supported, other changes to the data need clearPyramid(). */
+
+class PyramidGraph : public QCPGraph
+{
+    Q_OBJECT
+public:
+    PyramidGraph(QCPAxis* keyAxis, QCPAxis* valueAxis);
+
+    // Add the buckets of the data not in the pyramid yet
+    void updatePyramid();
+    void clearPyramid();
+    // Bytes used by the pyramid
+    qint64 pyramidMemoryUsage() const;
+
+    static const int baseBucketSize = 32;
+
+protected:
+    void getOptimizedLineData(QVector<QCPGraphData>* lineData,
+                              const QCPGraphDataContainer::const_iterator& begin,
+                              const QCPGraphDataContainer::const_iterator& end) const override;
+
+private:
+    struct Bucket
+    {
+        double first = 0;
+        double last = 0;
+        double min = 0;
+        double max = 0;
+    };
+    // Level i has buckets of baseBucketSize << i points
+    QVector<QVector<Bucket>> mLevels;
+    static Bucket combine(const Bucket& a, const Bucket& b);
+};
+
+#endif // PYRAMIDGRAPH_H
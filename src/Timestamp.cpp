@@ -0,0 +1,194 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#include "Timestamp.h"
+#include "NumberParser.h"
+
+#include <QDateTime>
+
+namespace {
+
+const int secondsPerDay = 86400;
+
+inline bool isDigit(char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+// Value of count digits at p, or -1 if they're not all digits
+inline int digits(const char* p, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        if (!isDigit(p[i])) { return -1; }
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+bool isLeapYear(int year)
+{
+    return ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+}
+
+int daysInMonth(int year, int month)
+{
+    static const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if ((month == 2) && isLeapYear(year)) { return 29; }
+    return days[month - 1];
+}
+
+} // namespace
+
+bool Timestamp::toSeconds(const char* begin, const char* end, double* value)
+{
+    NumberParser::trim(&begin, &end);
+
+    const char* p = begin;
+    // Quick rejection of anything that doesn't start like a date or time
+    if ((end - p < 4) || !isDigit(p[0])) { return false; }
+
+    bool hasDate = (end - p >= 10) && ((p[4] == '-') || (p[4] == '/'));
+    if (!hasDate) {
+        // Time of day
+        double seconds = 0;
+        if (!parseTime(p, end, &seconds) || (p != end)) { return false; }
+        *value = seconds;
+        return true;
+    }
+
+    int year = digits(p, 4);
+    int month = digits(p + 5, 2);
+    int day = digits(p + 8, 2);
+    if ((year < 0) || (p[7] != p[4])) { return false; }
+    if ((month < 1) || (month > 12)) { return false; }
+    if ((day < 1) || (day > daysInMonth(year, month))) { return false; }
+    p += 10;
+
+    double seconds = double(daysFromCivil(year, month, day)) * secondsPerDay;
+    if (p == end) {
+        *value = seconds;
+        return true;
+    }
+
+    if ((*p != 'T') && (*p != ' ')) { return false; }
+    p++;
+    double time = 0;
+    if (!parseTime(p, end, &time)) { return false; }
+    int offset = 0;
+    if ((p < end) && !parseZone(p, end, &offset)) { return false; }
+    if (p != end) { return false; }
+
+    *value = seconds + time - offset;
+    return true;
+}
+
+QString Timestamp::toString(double seconds)
+{
+    qint64 msecs = qRound64(seconds * 1000);
+    QDateTime dt = QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+    QString format = (msecs % 1000 != 0) ? "hh:mm:ss.zzz" : "hh:mm:ss";
+    if ((msecs < 0) || (msecs >= qint64(secondsPerDay) * 1000)) {
+        format.prepend("yyyy-MM-dd ");
+    }
+    return dt.toString(format);
+}
+
+qint64 Timestamp::daysFromCivil(int year, int month, int day)
+{
+    // Howard Hinnant's days_from_civil(), with March as the first month so
+    // the leap day is at the end of the year
+    qint64 y = year - ((month <= 2) ? 1 : 0);
+    qint64 era = ((y >= 0) ? y : y - 399) / 400;
+    qint64 yearOfEra = y - era * 400;
+    qint64 dayOfYear = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    qint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+bool Timestamp::parseTime(const char*& p, const char* end, double* seconds)
+{
+    // h:mm or hh:mm, then optionally :ss and a fraction
+    int hourDigits = ((end - p >= 2) && isDigit(p[1])) ? 2 : 1;
+    if (end - p < hourDigits + 3) { return false; }
+    int hour = digits(p, hourDigits);
+    p += hourDigits;
+    if ((hour < 0) || (hour > 23) || (*p != ':')) { return false; }
+    int minute = digits(p + 1, 2);
+    if ((minute < 0) || (minute > 59)) { return false; }
+    p += 3;
+
+    int second = 0;
+    double fraction = 0;
+    if ((end - p >= 3) && (*p == ':')) {
+        second = digits(p + 1, 2);
+        // 60 for a leap second
+        if ((second < 0) || (second > 60)) { return false; }
+        p += 3;
+
+        if ((p < end) && ((*p == '.') || (*p == ','))) {
+            p++;
+            if ((p == end) || !isDigit(*p)) { return false; }
+            // Up to nanoseconds, further digits are ignored
+            qint64 numerator = 0;
+            qint64 denominator = 1;
+            while ((p < end) && isDigit(*p)) {
+                if (denominator < 1000000000) {
+                    numerator = numerator * 10 + (*p - '0');
+                    denominator *= 10;
+                }
+                p++;
+            }
+            fraction = double(numerator) / double(denominator);
+        }
+    }
+
+    *seconds = hour * 3600 + minute * 60 + second + fraction;
+    return true;
+}
+
+bool Timestamp::parseZone(const char*& p, const char* end, int* offsetSeconds)
+{
+    if (*p == 'Z') {
+        p++;
+        *offsetSeconds = 0;
+        return true;
+    }
+    if ((*p != '+') && (*p != '-')) { return false; }
+    int sign = (*p == '-') ? -1 : 1;
+    p++;
+
+    if (end - p < 2) { return false; }
+    int hours = digits(p, 2);
+    p += 2;
+    int minutes = 0;
+    if ((end - p >= 3) && (*p == ':')) { p++; }
+    if (end - p >= 2) {
+        minutes = digits(p, 2);
+        p += 2;
+    }
+    if ((hours < 0) || (hours > 23) || (minutes < 0) || (minutes > 59)) {
+        return false;
+    }
+
+    *offsetSeconds = sign * (hours * 3600 + minutes * 60);
+    return true;
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ * This file is part of GidPlot.
+ * Copyright (C) 2026 Gideon van der Kolf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <QString>
+
+/* Timestamp converts date and time text to seconds since the Unix epoch,
+ * directly from a range of bytes, without allocating and independent of the
+ * locale, like NumberParser. Only fixed formats are accepted, so the parse
+ * is a few digit checks:
+ *
+ *   2024-03-01                    Date (also with / instead of -)
+ *   2024-03-01T12:34:56.789       ISO 8601 date and time (also with a space
+ *                                 instead of T). Seconds and fraction are
+ *                                 optional.
+ *   2024-03-01T12:34:56+02:00     With a zone: Z, +hh, +hhmm or +hh:mm
+ *   12:34:56.789                  Time of day, as seconds since midnight
+ *                                 (i.e. on 1970-01-01)
+ *
+ * Times without a zone are taken as UTC, which is also how they are shown
+ * (see toString()), so they show as written. Leading and trailing whitespace
+ * is ignored. */
+
+class Timestamp
+{
+public:
+    static bool toSeconds(const char* begin, const char* end, double* value);
+
+    // Date and time of seconds since the epoch in UTC, or only the time for
+    // times of day. Milliseconds are only shown if not zero.
+    static QString toString(double seconds);
+    // Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+    static qint64 daysFromCivil(int year, int month, int day);
+
+private:
+    static bool parseTime(const char*& p, const char* end, double* seconds);
+    static bool parseZone(const char*& p, const char* end, int* offsetSeconds);
+};
+
+#endif // TIMESTAMP_H
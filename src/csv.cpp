@@ -19,6 +19,9 @@
  *****************************************************************************/
 
 #include "csv.h"
+#include "CsvScanner.h"
+
+#include <cstring>
 
 
 QList<RangePtr> Csv::ranges()
@@ -37,34 +40,57 @@ Range Csv::allRange()
     return Range("All", 0, matrix->rowCount());
 }
 
+void Csv::appendChunk(const Matrix::Chunk &chunk)
+{
+    if (!matrix) { return; }
+    if (chunk.rowCount == 0) { return; }
+
+    int firstRow = matrix->rowCount();
+    matrix->appendChunk(chunk);
+    // Make columns contiguous once here instead of on first access
+    matrix->squeeze();
+    emit rowsAppended(firstRow, matrix->rowCount() - firstRow);
+}
+
 QByteArrayList Csv::separateLine(const QByteArray &line, FileInfo fileInfo)
 {
-    if (fileInfo.combineSeparators) {
-        QByteArray line2;
-        bool lastWasSep = false;
-        for (int i = 0; i < line.count(); i++) {
-            char c = line.at(i);
-            if (c == '\n') { break; } // Do not add newlines to output
-            bool isSep = (c == fileInfo.separator);
-            if (i == 0) {
-                // Skip leading separator
-                if (!isSep) {
-                    line2.append(c);
-                }
-            } else {
-                bool repeatedSep = isSep && lastWasSep;
-                if (!repeatedSep) {
-                    line2.append(c);
-                }
-            }
-            lastWasSep = isSep;
-        }
-        // Remove trailing separator
-        if (line2.endsWith(fileInfo.separator)) {
-            line2.remove(line2.count() - 1, 1);
-        }
-        return line2.split(fileInfo.separator);
-    } else {
-        return line.split(fileInfo.separator);
+    const char* nextLine;
+    const char* lineEnd = findLineEnd(line.constData(),
+                                      line.constData() + line.size(), &nextLine);
+    QVector<ByteSpan> fields;
+    separateLine(line.constData(), lineEnd, fileInfo, fields);
+
+    QByteArrayList ret;
+    foreach (const ByteSpan& field, fields) {
+        ret.append(field.toByteArray());
     }
+    return ret;
+}
+
+void Csv::separateLine(const char* begin, const char* end,
+                       const FileInfo& fileInfo, QVector<ByteSpan>& fields)
+{
+    // The resulting fields point into the line and nothing is copied. The line
+    // must not include the newline. The fields vector is cleared, keeping its
+    // capacity so it can be reused for the next line without reallocating.
+    // See CsvScanner for details of how fields are separated.
+
+    CsvScanner scanner(fileInfo.separator, fileInfo.combineSeparators);
+    scanner.scanLine(begin, end, fields);
+}
+
+const char* Csv::findLineEnd(const char* line, const char* end,
+                             const char** nextLine)
+{
+    // Returns the end of the line content, excluding the newline and a
+    // possible carriage return, and sets nextLine to the start of the next
+    // line (or end if this is the last line).
+
+    const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    const char* lineEnd = eol ? eol : end;
+    *nextLine = eol ? (eol + 1) : end;
+
+    if ((lineEnd > line) && (*(lineEnd - 1) == '\r')) { lineEnd--; }
+
+    return lineEnd;
 }
@@ -21,6 +21,7 @@
 #ifndef CSV_H
 #define CSV_H
 
+#include "ByteSpan.h"
 #include "matrix.h"
 #include "Range.h"
 
@@ -36,12 +37,38 @@ public:
         int dataStartRow = 0;
         char separator = ',';
         bool combineSeparators = false;
+        // Memory-map the file and parse fields in place instead of reading
+        // it line by line. Falls back to reading if the file can't be mapped.
+        bool memoryMap = true;
+        // Keep watching the file after import and append rows as they are
+        // written to it, like tail -f.
+        bool follow = false;
+        // Load from and save to a cache file of the imported data (CsvCache)
+        bool useCache = true;
+        // Only index the lines on import and read columns when first used
+        // (CsvSource). Not for compressed or followed files. Always mapped.
+        bool lazy = false;
 
     } fileInfo;
 
     struct ImportInfo
     {
         qint64 timeSecs = 0;
+        qint64 timeMs = 0;
+        bool memoryMapped = false;
+        // Name of the compression format, empty if not compressed
+        QString compression;
+        // Loaded from the cache file instead of importing
+        bool fromCache = false;
+        // Lines indexed, columns read when used
+        bool lazy = false;
+        // Stopped by the user. Nothing was loaded.
+        bool cancelled = false;
+        // Name of the file format if not CSV, e.g. Parquet
+        QString format;
+        // Peak resident memory of the process at the end of the import, in
+        // bytes, or -1 if not available
+        qint64 peakMemory = -1;
         bool success = false;
         QString info;
     } importInfo;
@@ -51,11 +78,20 @@ public:
     Range allRange();
 
     MatrixPtr matrix;
+    // Append rows read after the import (follow mode) and notify listeners
+    void appendChunk(const Matrix::Chunk& chunk);
 
     static QByteArrayList separateLine(const QByteArray& line, FileInfo fileInfo);
+    static void separateLine(const char* begin, const char* end,
+                             const FileInfo& fileInfo, QVector<ByteSpan>& fields);
+    static const char* findLineEnd(const char* line, const char* end,
+                                   const char** nextLine);
 
 signals:
     void rangeAdded(RangePtr range);
+    // Rows were appended to the matrix. Column views taken before are no
+    // longer valid.
+    void rowsAppended(int firstRow, int count);
 
 private:
     QList<RangePtr> mRanges;
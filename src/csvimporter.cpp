@@ -19,39 +19,97 @@
  *****************************************************************************/
 
 #include "csvimporter.h"
+#include "ArrowSource.h"
+#include "CompressedFile.h"
+#include "CsvCache.h"
+#include "CsvScanner.h"
+#include "CsvSource.h"
+#include "ProcessMemory.h"
 
 #include <QDebug>
+#include <QLocale>
+#include <QtConcurrent>
+
+#include <limits>
 
 CsvImporter::CsvImporter(QObject *parent) : QObject(parent)
 {
     qRegisterMetaType<CsvPtr>("CsvPtr");
+    mPool.setMaxThreadCount(defaultWorkerCount);
+}
+
+CsvImporter::~CsvImporter()
+{
+    {
+        QMutexLocker locker(&mJobsMutex);
+        foreach (JobPtr job, mJobs) {
+            job->cancelled.storeRelease(1);
+        }
+    }
+    mPool.waitForDone();
 }
 
 CsvPtr CsvImporter::importCsv(Csv::FileInfo info)
 {
     CsvPtr csv(new Csv());
     csv->fileInfo = info;
-    csvDataList.append(csv);
 
-    runInCsvThread([this, csvWeakPtr = CsvWeakPtr(csv)]()
+    JobPtr job(new Job());
+    job->csv = csv;
     {
-        CsvPtr csv2(csvWeakPtr);
-        if (!csv2) { return; }
-        doImport(csv2);
-    });
+        QMutexLocker locker(&mJobsMutex);
+        mJobs.append(job);
+    }
+    QtConcurrent::run(&mPool, [this, job]() { doImport(job); });
 
     return csv;
 }
 
-void CsvImporter::removeCsv(CsvPtr csv)
+void CsvImporter::cancelImport(CsvPtr csv)
+{
+    QMutexLocker locker(&mJobsMutex);
+    foreach (JobPtr job, mJobs) {
+        if (job->csv == csv) {
+            job->cancelled.storeRelease(1);
+        }
+    }
+}
+
+void CsvImporter::setWorkerCount(int count)
+{
+    mPool.setMaxThreadCount(qMax(1, count));
+}
+
+int CsvImporter::workerCount() const
+{
+    return mPool.maxThreadCount();
+}
+
+CsvImporter::Pause::Pause(CsvImporter* importer) : mImporter(importer)
+{
+    mImporter->mPauseCount.ref();
+}
+
+CsvImporter::Pause::~Pause()
 {
-    csvDataList.removeAll(csv);
+    mImporter->mPauseCount.deref();
 }
 
-void CsvImporter::emitImportFinishedAndRemoveCsv(CsvPtr csv)
+bool CsvImporter::checkpoint(const Job& job) const
 {
-    csvDataList.removeAll(csv);
-    emit importFinished(csv);
+    while ((mPauseCount.loadAcquire() > 0) && !job.isCancelled()) {
+        QThread::msleep(10);
+    }
+    return !job.isCancelled();
+}
+
+void CsvImporter::emitImportFinishedAndRemoveJob(JobPtr job)
+{
+    {
+        QMutexLocker locker(&mJobsMutex);
+        mJobs.removeAll(job);
+    }
+    emit importFinished(job->csv);
 }
 
 void CsvImporter::runInCsvThread(std::function<void ()> func)
@@ -59,65 +117,556 @@ void CsvImporter::runInCsvThread(std::function<void ()> func)
     QMetaObject::invokeMethod(this, func, Qt::QueuedConnection);
 }
 
-void CsvImporter::doImport(CsvPtr csv)
+void CsvImporter::doImport(JobPtr job)
 {
+    CsvPtr csv = job->csv;
+    job->timer.start();
+
+    // Cancelled while waiting for a worker
+    if (!checkpoint(*job)) {
+        csv->importInfo.cancelled = true;
+        csv->importInfo.info = "Import cancelled.";
+        emitImportFinishedAndRemoveJob(job);
+        return;
+    }
+
     QFile file(csv->fileInfo.filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         // Error opening file
         csv->importInfo.success = false;
         csv->importInfo.info = "Error opening file: " + file.errorString();
-        emitImportFinishedAndRemoveCsv(csv);
+        emitImportFinishedAndRemoveJob(job);
         return;
     }
 
-    QElapsedTimer timer;
-    timer.start();
+    emit importProgress(csv, "Starting");
+
+    bool mapped = false;
+    qint64 importedSize = 0;
+    CompressedFile::Compression compression = CompressedFile::compression(file);
+    ArrowSource::Format arrowFormat = ArrowSource::format(csv->fileInfo.filename);
+    bool csvFormat = (arrowFormat == ArrowSource::NoFormat);
+    if ((compression != CompressedFile::NoCompression) || !csvFormat) {
+        if (csv->fileInfo.follow) {
+            qDebug() << "Can't follow file:" << csv->fileInfo.filename;
+            csv->fileInfo.follow = false;
+        }
+    }
+    // Appended rows are added to the matrix, which can't be combined with
+    // reading columns from the file later
+    bool tryLazy = csv->fileInfo.lazy && csvFormat && !csv->fileInfo.follow
+            && (compression == CompressedFile::NoCompression);
+    bool lazy = false;
+    // Taken before importing so a cache is not used if the file changes
+    // while it is being imported
+    CsvCache::Key cacheKey = CsvCache::Key::fromFileInfo(csv->fileInfo);
+    bool fromCache = csvFormat && csv->fileInfo.useCache
+            && CsvCache::load(csv, importedSize);
+    if (!csvFormat) {
+        file.close();
+        importArrow(*job);
+    } else if (fromCache) {
+        // Nothing to parse
+        file.close();
+    } else if (compression != CompressedFile::NoCompression) {
+        file.close();
+        importCompressed(*job);
+    } else if (tryLazy && importLazy(*job)) {
+        // Mapped by the source
+        lazy = true;
+        mapped = true;
+        importedSize = file.size();
+    } else if (csv->fileInfo.memoryMap && (file.size() > 0)) {
+        uchar* data = file.map(0, file.size());
+        if (data) {
+            mapped = true;
+            const char* text = reinterpret_cast<const char*>(data);
+            importedSize = file.size();
+            if (csv->fileInfo.follow) {
+                // Leave a line that is still being written for later
+                importedSize = completeLinesSize(text, importedSize);
+            }
+            importMapped(*job, text, importedSize);
+            file.unmap(data);
+        } else {
+            qDebug() << "Could not memory-map file, reading instead:"
+                     << file.errorString();
+        }
+    }
+    if (csvFormat && !fromCache && !mapped
+            && (compression == CompressedFile::NoCompression)) {
+        // Text mode converts line endings for us when reading line by line
+        file.setTextModeEnabled(true);
+        importedSize = importStreamed(*job, file);
+    }
+
+    file.close();
+
+    if (csv->matrix) {
+        csv->matrix->squeeze();
+    }
 
+    if (job->isCancelled()) {
+        // Rows imported so far are dropped
+        csv->matrix.reset();
+        csv->importInfo.cancelled = true;
+        csv->importInfo.info = "Import cancelled.";
+        emitImportFinishedAndRemoveJob(job);
+        return;
+    }
+
+    csv->importInfo.timeMs = job->timer.elapsed();
+    csv->importInfo.peakMemory = ProcessMemory::peak();
+    csv->importInfo.timeSecs = csv->importInfo.timeMs / 1000;
+
+    // Not after errors that cut the import short, e.g. decompression errors
+    if (csvFormat && !fromCache && !lazy && csv->matrix
+            && csv->importInfo.info.isEmpty()
+            && csv->fileInfo.useCache && (cacheKey.size >= CsvCache::minFileSize)) {
+        emit importProgress(csv, "Writing cache file");
+        QString error;
+        if (!CsvCache::save(csv, cacheKey, importedSize, error)) {
+            qDebug() << "Could not write cache file:" << error;
+        }
+    }
+    csv->importInfo.memoryMapped = mapped;
+    csv->importInfo.compression = CompressedFile::compressionName(compression);
+    csv->importInfo.fromCache = fromCache;
+    csv->importInfo.lazy = lazy;
+    csv->importInfo.format = ArrowSource::formatName(arrowFormat);
+
+    if (csv->matrix.isNull()) {
+        // No data was loaded
+        csv->importInfo.success = false;
+        if (csv->importInfo.info.isEmpty()) {
+            csv->importInfo.info = "No data found in file.";
+        }
+    } else {
+        csv->importInfo.success = true;
+        if (csv->fileInfo.follow) {
+            // In this object's thread, which has the follow timer
+            runInCsvThread([this, csv, importedSize]()
+            {
+                startFollowing(csv, importedSize);
+            });
+        }
+    }
+
+    emitImportFinishedAndRemoveJob(job);
+}
+
+void CsvImporter::importArrow(Job& job)
+{
+    CsvPtr csv = job.csv;
+    QString error;
+    ColumnSourcePtr source = ArrowSource::open(csv->fileInfo.filename, error);
+    if (!source) {
+        csv->importInfo.info = "Error opening file: " + error;
+        return;
+    }
+    // Only the headings and row count are read here. Columns are read when
+    // they are first viewed or plotted.
+    csv->fileInfo.headings = source->headings();
+    initMatrix(csv, source->headings().count());
+    csv->matrix->setSource(source);
+}
+
+bool CsvImporter::importLazy(Job& job)
+{
+    CsvPtr csv = job.csv;
+    QString error;
+    CsvSourcePtr source = CsvSource::open(csv->fileInfo,
+                                          [&](qint64 bytesIndexed, qint64 size)
+    {
+        emit importProgress(csv, QString("Indexing lines (%1 %) (%2) (%3 seconds elapsed)%4")
+                            .arg((bytesIndexed * 100) / size)
+                            .arg(throughputText(job, bytesIndexed))
+                            .arg(job.timer.elapsed() / 1000)
+                            .arg(peakMemoryText()));
+        return checkpoint(job);
+    }, error);
+    if (job.isCancelled()) {
+        // Not imported another way instead
+        return true;
+    }
+    if (!source) {
+        qDebug() << "Could not index file, importing all columns instead:"
+                 << error;
+        return false;
+    }
+    if (source->rowCount() == 0) {
+        // No data
+        return true;
+    }
+    // Columns are read when they are first viewed or plotted
+    initMatrix(csv, source->columnCount());
+    csv->matrix->setSource(source);
+    return true;
+}
+
+void CsvImporter::importCompressed(Job& job)
+{
+    CsvPtr csv = job.csv;
+    CompressedFile file(csv->fileInfo.filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        csv->importInfo.info = "Error opening file: " + file.errorString();
+        return;
+    }
+
+    importStreamed(job, file);
+
+    QString error = file.decompressError();
+    if (!error.isEmpty()) {
+        // Keep the rows read up to the error
+        csv->importInfo.info = "Error decompressing file: " + error;
+    }
+    file.close();
+}
+
+qint64 CsvImporter::importStreamed(Job& job, QIODevice& file)
+{
+    CsvPtr csv = job.csv;
     QElapsedTimer progressFeedbackTimer;
     progressFeedbackTimer.start();
-    emit importProgress(csv, "Starting");
 
-    qint64 filesize = file.size();
+    // Progress of compressed files is based on the compressed bytes consumed,
+    // as the decompressed size is not known up front.
+    CompressedFile* compressed = qobject_cast<CompressedFile*>(&file);
+
+    qint64 filesize = compressed ? compressed->compressedSize() : file.size();
     qint64 bytesread = 0;
+    qint64 dataStartBytes = 0;
+
+    qint64 importedSize = 0;
 
+    // The first data lines are held back until they decide which columns
+    // hold categories and timestamps
+    Matrix::ColumnSample columnSample;
+    QList<QByteArrayList> sampleLines;
+    auto addSampleLines = [&]()
+    {
+        csv->matrix->setCategoryColumns(columnSample.categoryColumns());
+        csv->matrix->setTimeColumns(
+                    columnSample.timeColumns(csv->fileInfo.headings));
+        foreach (const QByteArrayList& values, sampleLines) {
+            csv->matrix->addCsvLine(values);
+        }
+        sampleLines.clear();
+    };
 
     for (int lineNum = 0; !file.atEnd(); lineNum++) {
+        if (((lineNum % checkpointLines) == 0) && !checkpoint(job)) { break; }
         QByteArray line = file.readLine();
         bytesread += line.count();
-        if (lineNum < csv->fileInfo.dataStartRow) { continue; }
+        if (csv->fileInfo.follow && !line.endsWith('\n')) {
+            // Leave a line that is still being written for later
+            break;
+        }
+        importedSize = file.pos();
+        if (lineNum < csv->fileInfo.dataStartRow) {
+            dataStartBytes = bytesread;
+            continue;
+        }
 
         QByteArrayList values = Csv::separateLine(line, csv->fileInfo);
 
         if (lineNum == csv->fileInfo.dataStartRow) {
-            // First data row. Initialise matrix.
-            int colNumGuess = qMax(values.count(), csv->fileInfo.headings.count());
-            csv->matrix.reset(new Matrix(colNumGuess));
-            csv->matrix->setHeadingsExcludingIndexColumn(csv->fileInfo.headings);
+            initMatrix(csv, values.count());
         }
 
-        csv->matrix->addCsvLine(values);
+        if (columnSample.isFull()) {
+            csv->matrix->addCsvLine(values);
+        } else {
+            columnSample.addLine(values);
+            sampleLines.append(values);
+            if (columnSample.isFull()) { addSampleLines(); }
+        }
+
+        if (lineNum == csv->fileInfo.dataStartRow + estimateSampleRows) {
+            // Size matrix columns for the rest of the file
+            qint64 dataSize = compressed ? compressed->estimatedSize() : filesize;
+            csv->matrix->reserveRows(estimateRowCount(
+                    dataSize - dataStartBytes, bytesread - dataStartBytes,
+                    estimateSampleRows + 1));
+        }
 
         if (progressFeedbackTimer.elapsed() > 100) {
-            emit importProgress(csv,
-                                QString("%1 lines (%2 %) (%3 errors) (%4 seconds elapsed)")
-                                .arg(lineNum + 1)
-                                .arg((bytesread * 100) / filesize)
-                                .arg(csv->matrix->errorCount())
-                                .arg(timer.elapsed() / 1000));
+            progressFeedbackTimer.restart();
+            qint64 pos = compressed ? compressed->compressedPos() : bytesread;
+            emitProgress(job, pos, filesize);
         }
     }
 
-    file.close();
+    if (!sampleLines.isEmpty()) {
+        // Fewer lines than a full sample, or stopped early
+        addSampleLines();
+    }
 
-    csv->importInfo.timeSecs = timer.elapsed() / 1000;
+    return importedSize;
+}
 
-    if (csv->matrix.isNull()) {
-        // No data was loaded
-        csv->importInfo.success = false;
-        csv->importInfo.info = "No data found in file.";
-    } else {
-        csv->importInfo.success = true;
+void CsvImporter::importMapped(Job& importJob, const char* data, qint64 size)
+{
+    CsvPtr csv = importJob.csv;
+    const char* end = data + size;
+
+    // Skip to start of data
+    const char* dataStart = data;
+    for (int lineNum = 0; lineNum < csv->fileInfo.dataStartRow; lineNum++) {
+        if (dataStart >= end) { break; }
+        Csv::findLineEnd(dataStart, end, &dataStart);
+    }
+    if (dataStart >= end) {
+        // No data
+        return;
+    }
+
+    // Use first data row to initialise matrix
+    QVector<ByteSpan> values;
+    const char* nextLine;
+    const char* lineEnd = Csv::findLineEnd(dataStart, end, &nextLine);
+    Csv::separateLine(dataStart, lineEnd, csv->fileInfo, values);
+    initMatrix(csv, values.count());
+
+    // Size matrix columns from the number of lines in a sample. The first
+    // lines of it decide which columns hold categories and timestamps, up
+    // front as the chunks are parsed in parallel.
+    Matrix::ColumnSample columnSample;
+    qint64 dataSize = end - dataStart;
+    const char* sampleEnd = dataStart;
+    int sampleRows = 0;
+    while ((sampleEnd < end) && (sampleRows < estimateSampleRows)) {
+        const char* sampleLine = sampleEnd;
+        lineEnd = Csv::findLineEnd(sampleLine, end, &sampleEnd);
+        if (!columnSample.isFull()) {
+            Csv::separateLine(sampleLine, lineEnd, csv->fileInfo, values);
+            columnSample.addLine(values);
+        }
+        sampleRows++;
+    }
+    QVector<bool> categoryCols = columnSample.categoryColumns();
+    QVector<bool> timeCols = columnSample.timeColumns(csv->fileInfo.headings);
+    csv->matrix->reserveRows(estimateRowCount(dataSize, sampleEnd - dataStart,
+                                              sampleRows));
+
+    // Split data into chunks at line boundaries. Use more chunks than threads
+    // so the work is spread evenly and chunks can be appended to the matrix
+    // (and freed) while the rest are still being parsed.
+    int chunkCount = qBound<qint64>(1, dataSize / minChunkSize,
+                                    QThread::idealThreadCount() * 4);
+    QVector<ParseJob> jobs(chunkCount);
+    const char* chunkStart = dataStart;
+    for (int i = 0; i < chunkCount; i++) {
+        ParseJob& job = jobs[i];
+        job.begin = chunkStart;
+        job.chunk.categoryCols = categoryCols;
+        job.chunk.timeCols = timeCols;
+        if (i == chunkCount - 1) {
+            job.end = end;
+        } else {
+            const char* splitPos = dataStart + (dataSize * (i + 1)) / chunkCount;
+            splitPos = qMax(splitPos, chunkStart);
+            Csv::findLineEnd(splitPos, end, &job.end);
+        }
+        chunkStart = job.end;
+    }
+
+    QAtomicInteger<qint64> bytesParsed(0);
+    const Job* importJobPtr = &importJob;
+    for (int i = 0; i < chunkCount; i++) {
+        ParseJob* job = &jobs[i];
+        const Csv::FileInfo* fileInfo = &csv->fileInfo;
+        job->future = QtConcurrent::run([this, job, fileInfo, &bytesParsed,
+                                         importJobPtr]()
+        {
+            parseChunk(job, fileInfo, &bytesParsed, importJobPtr);
+        });
+    }
+
+    // Append chunks to the matrix in order as they become available
+    QElapsedTimer progressFeedbackTimer;
+    progressFeedbackTimer.start();
+
+    for (int i = 0; i < chunkCount; i++) {
+        ParseJob& job = jobs[i];
+        while (!job.future.isFinished()) {
+            QThread::msleep(10);
+            if (progressFeedbackTimer.elapsed() > 100) {
+                progressFeedbackTimer.restart();
+                qint64 parsed = bytesParsed.loadAcquire() + (dataStart - data);
+                emitProgress(importJob, parsed, size);
+            }
+        }
+        if (importJob.isCancelled()) { break; }
+        csv->matrix->appendChunk(job.chunk);
+        // Free chunk memory
+        job.chunk = Matrix::Chunk();
     }
 
-    emitImportFinishedAndRemoveCsv(csv);
+    // Chunks of a cancelled import stop early, but still point into the data
+    for (int i = 0; i < chunkCount; i++) {
+        jobs[i].future.waitForFinished();
+    }
+}
+
+void CsvImporter::parseChunk(ParseJob* job, const Csv::FileInfo* fileInfo,
+                             QAtomicInteger<qint64>* bytesParsed,
+                             const Job* importJob) const
+{
+    // Fields point straight into the mapped file. Lines are separated in
+    // blocks and the vectors are reused for every block, so nothing is
+    // allocated per line or per field.
+    CsvScanner scanner(fileInfo->separator, fileInfo->combineSeparators);
+    QVector<ByteSpan> fields;
+    QVector<int> lineFieldIndex;
+
+    const char* pos = job->begin;
+    while (pos < job->end) {
+        if (importJob && !checkpoint(*importJob)) { return; }
+        const char* blockStart = pos;
+        pos = scanner.scan(pos, job->end, 256, fields, lineFieldIndex);
+        for (int i = 0; i < lineFieldIndex.count() - 1; i++) {
+            job->chunk.addCsvLine(fields.constData() + lineFieldIndex[i],
+                                  lineFieldIndex[i + 1] - lineFieldIndex[i]);
+        }
+        bytesParsed->fetchAndAddRelaxed(pos - blockStart);
+    }
+}
+
+void CsvImporter::initMatrix(CsvPtr csv, int firstRowFieldCount)
+{
+    // First data row. Initialise matrix.
+    int colNumGuess = qMax(firstRowFieldCount, csv->fileInfo.headings.count());
+    csv->matrix.reset(new Matrix(colNumGuess));
+    csv->matrix->setHeadingsExcludingIndexColumn(csv->fileInfo.headings);
+}
+
+void CsvImporter::startFollowing(CsvPtr csv, qint64 pos)
+{
+    Follow follow;
+    follow.csv = csv;
+    follow.fileInfo = csv->fileInfo;
+    follow.pos = pos;
+    follow.categoryCols = csv->matrix->categoryColumns();
+    follow.timeCols = csv->matrix->timeColumns();
+    mFollows.append(follow);
+
+    if (!mFollowTimer) {
+        // Created here so it lives in this object's thread
+        mFollowTimer = new QTimer(this);
+        mFollowTimer->setInterval(followIntervalMs);
+        connect(mFollowTimer, &QTimer::timeout, this, &CsvImporter::followFiles);
+    }
+    mFollowTimer->start();
+}
+
+void CsvImporter::followFiles()
+{
+    for (int i = mFollows.count() - 1; i >= 0; i--) {
+        CsvPtr csv(mFollows[i].csv);
+        // Stop when the CSV has been closed
+        if (!csv || !readAppended(mFollows[i], csv)) {
+            mFollows.removeAt(i);
+        }
+    }
+
+    if (mFollows.isEmpty()) {
+        mFollowTimer->stop();
+    }
+}
+
+bool CsvImporter::readAppended(Follow &follow, CsvPtr csv)
+{
+    QFile file(follow.fileInfo.filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        // Could be temporary, try again next time
+        return true;
+    }
+
+    qint64 size = file.size();
+    if (size < follow.pos) {
+        // Truncated or replaced. The rows read so far no longer match.
+        qDebug() << "Stopped following file as it got smaller:"
+                 << follow.fileInfo.filename;
+        return false;
+    }
+    if ((size == follow.pos) || !file.seek(follow.pos)) { return true; }
+
+    QByteArray text = file.read(qMin(size - follow.pos, maxFollowReadSize));
+    int lastNewline = text.lastIndexOf('\n');
+    if (lastNewline < 0) {
+        // Line not complete yet
+        return true;
+    }
+    text.truncate(lastNewline + 1);
+    follow.pos += text.size();
+
+    QSharedPointer<ParseJob> job(new ParseJob());
+    job->begin = text.constData();
+    job->end = text.constData() + text.size();
+    job->chunk.categoryCols = follow.categoryCols;
+    job->chunk.timeCols = follow.timeCols;
+    QAtomicInteger<qint64> bytesParsed(0);
+    parseChunk(job.data(), &follow.fileInfo, &bytesParsed, nullptr);
+
+    // The chunk points into text, which the lambda keeps alive. The matrix
+    // is only modified in the Csv's (GUI) thread after the import.
+    QMetaObject::invokeMethod(csv.data(), [csvWeak = follow.csv, text, job]()
+    {
+        CsvPtr csv(csvWeak);
+        if (!csv) { return; }
+        csv->appendChunk(job->chunk);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+qint64 CsvImporter::completeLinesSize(const char *data, qint64 size)
+{
+    while ((size > 0) && (data[size - 1] != '\n')) {
+        size--;
+    }
+    return size;
+}
+
+int CsvImporter::estimateRowCount(qint64 dataSize, qint64 sampleSize,
+                                  int sampleRows)
+{
+    if ((sampleSize <= 0) || (sampleRows <= 0)) { return 0; }
+    double bytesPerRow = double(sampleSize) / sampleRows;
+    double estimate = dataSize / bytesPerRow * 1.05 + 1;
+    // Rows are indexed with int
+    return int(qMin(estimate, double(std::numeric_limits<int>::max())));
+}
+
+void CsvImporter::emitProgress(Job& job, qint64 bytesDone, qint64 bytesTotal)
+{
+    CsvPtr csv = job.csv;
+    int rows = csv->matrix ? csv->matrix->rowCount() : 0;
+    int errors = csv->matrix ? csv->matrix->errorCount() : 0;
+    emit importProgress(csv,
+                        QString("%1 rows (%2 %) (%3 errors) (%4) (%5 seconds elapsed)%6")
+                        .arg(rows)
+                        .arg((bytesDone * 100) / qMax<qint64>(1, bytesTotal))
+                        .arg(errors)
+                        .arg(throughputText(job, bytesDone, rows))
+                        .arg(job.timer.elapsed() / 1000)
+                        .arg(peakMemoryText()));
+}
+
+QString CsvImporter::throughputText(const Job& job, qint64 bytes, int rows)
+{
+    double secs = qMax<qint64>(1, job.timer.elapsed()) / 1000.0;
+    QString text = QString("%1 MB/s").arg(bytes / secs / (1024 * 1024), 0, 'f', 1);
+    if (rows >= 0) {
+        text += QString(", %1 rows/s").arg(qint64(rows / secs));
+    }
+    return text;
+}
+
+QString CsvImporter::peakMemoryText()
+{
+    qint64 peak = ProcessMemory::peak();
+    if (peak < 0) { return ""; }
+    return QString(" (peak memory %1)").arg(QLocale().formattedDataSize(peak));
 }
@@ -23,36 +23,151 @@
 
 #include "csv.h"
 
+#include <QAtomicInteger>
 #include <QElapsedTimer>
 #include <QFile>
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 
 #include <functional>
 
 
+/* CsvImporter imports files in the background. Each import is a job run by
+ * a thread pool, so several files are imported at the same time, up to the
+ * worker count. Further imports wait for a free worker.
+ *
+ * Jobs check for cancellation and pausing between chunks of work (lines,
+ * parse chunks or index blocks). A cancelled import finishes with
+ * importInfo.cancelled set and without data. Progress is reported with
+ * importProgress(), including the throughput so far. */
+
 class CsvImporter : public QObject
 {
     Q_OBJECT
 public:
     explicit CsvImporter(QObject *parent = nullptr);
+    ~CsvImporter();
 
     CsvPtr importCsv(Csv::FileInfo info);
-    void removeCsv(CsvPtr csv);
+    // Stops the import at the next check. importFinished() is still emitted.
+    void cancelImport(CsvPtr csv);
+    // Maximum number of files imported at the same time
+    void setWorkerCount(int count);
+    int workerCount() const;
+
+    /* Running imports pause while an object of this class exists, e.g. while
+     * the import dialog reads the preview of a file, so that takes priority
+     * and stays quick however many large files are being imported. */
+    class Pause
+    {
+    public:
+        explicit Pause(CsvImporter* importer);
+        ~Pause();
+    private:
+        CsvImporter* mImporter;
+        Q_DISABLE_COPY(Pause)
+    };
 
 signals:
     void importProgress(CsvPtr csv, QString info);
     void importFinished(CsvPtr csv);
 
 private:
-    QList<CsvPtr> csvDataList;
-    void emitImportFinishedAndRemoveCsv(CsvPtr csv);
+    struct Job
+    {
+        CsvPtr csv;
+        QElapsedTimer timer;
+        QAtomicInt cancelled;
+        bool isCancelled() const { return cancelled.loadAcquire() != 0; }
+    };
+    typedef QSharedPointer<Job> JobPtr;
+    // Queued and running jobs
+    QList<JobPtr> mJobs;
+    QMutex mJobsMutex;
+    QThreadPool mPool;
+    static const int defaultWorkerCount = 2;
+    // Lines read between checks when streaming
+    static const int checkpointLines = 1024;
+    QAtomicInt mPauseCount;
+    // Waits while imports are paused. Returns false if the job was cancelled.
+    bool checkpoint(const Job& job) const;
+    // Run by the thread pool
+    void doImport(JobPtr job);
+
+    void emitImportFinishedAndRemoveJob(JobPtr job);
 
     void runInCsvThread(std::function<void(void)> func);
 
+    // Returns the number of bytes of the file imported
+    qint64 importStreamed(Job& job, QIODevice& file);
+    // Streamed import of a gzip or zstd file, decompressed on the fly
+    void importCompressed(Job& job);
+    // Parquet or Arrow IPC file, with columns read on demand
+    void importArrow(Job& job);
+    // Index the lines of a CSV file and read columns on demand. Returns false
+    // if the file could not be mapped.
+    bool importLazy(Job& job);
+    void importMapped(Job& job, const char* data, qint64 size);
+    void initMatrix(CsvPtr csv, int firstRowFieldCount);
+    // Estimate of the number of rows in dataSize bytes from a sample, with
+    // some margin so the matrix columns don't need extra blocks
+    static int estimateRowCount(qint64 dataSize, qint64 sampleSize,
+                                int sampleRows);
+    static const int estimateSampleRows = 1000;
+    void emitProgress(Job& job, qint64 bytesDone, qint64 bytesTotal);
+    // Bytes and rows per second so far
+    static QString throughputText(const Job& job, qint64 bytes, int rows = -1);
+    static QString peakMemoryText();
+
+    // Mapped files are split into chunks at line boundaries which are parsed
+    // in parallel by the thread pool and then appended to the matrix in order.
+    struct ParseJob
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        Matrix::Chunk chunk;
+        QFuture<void> future;
+    };
+    static const qint64 minChunkSize = 1024 * 1024;
+    // Stops early if importJob is cancelled. Without an import job when
+    // following a file.
+    void parseChunk(ParseJob* job, const Csv::FileInfo* fileInfo,
+                    QAtomicInteger<qint64>* bytesParsed,
+                    const Job* importJob) const;
+
+    // -----------------------------------------------------------------------
+    // Follow mode: after import, files are polled for appended lines, which
+    // are parsed here and appended to the matrix in the Csv's thread.
+
+    struct Follow
+    {
+        CsvWeakPtr csv;
+        Csv::FileInfo fileInfo;
+        // Start of the first line not read yet
+        qint64 pos = 0;
+        // Of the matrix, for the chunks of appended lines
+        QVector<bool> categoryCols;
+        QVector<bool> timeCols;
+    };
+    QList<Follow> mFollows;
+    QTimer* mFollowTimer = nullptr;
+    // Also limits how often plots are updated
+    static const int followIntervalMs = 250;
+    // Most bytes read per poll, to keep the appending in the GUI responsive
+    static const qint64 maxFollowReadSize = 16 * 1024 * 1024;
+    void startFollowing(CsvPtr csv, qint64 pos);
+    // Returns false if the file can no longer be followed
+    bool readAppended(Follow& follow, CsvPtr csv);
+    // Size of data up to and including the last newline
+    static qint64 completeLinesSize(const char* data, qint64 size);
+
 private slots:
-    void doImport(CsvPtr csv);
+    void followFiles();
 
 };
 
@@ -21,6 +21,7 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include "GridHash.h"
 #include "csv.h"
 #include "QGVLine.h"
 
@@ -39,12 +40,9 @@
 
 // ===========================================================================
 
-enum ClosestOption { ClosestXOnly, ClosestXY };
-
-// ===========================================================================
-
 struct Track
 {
+    // Copies, as reading columns of a source moves the matrix's storage
     QVector<double> lats;
     QVector<double> lons;
 
@@ -58,37 +56,6 @@ typedef QSharedPointer<Track> TrackPtr;
 
 // ===========================================================================
 
-struct GridHash
-{
-    QRectF bounds;
-    int n = 100;
-
-    int maxcolrow();
-
-    struct Data
-    {
-        QPointF coord;
-        int index = 0;
-    };
-
-    QMultiMap<int, Data> map;
-
-    int hash(QPoint point);
-    QPoint colrow(QPointF coord);
-    int clipcolrow(int value);
-    void insert(QPointF coord, int index);
-
-    struct Result
-    {
-        QList<Data> data;
-        bool maxedOut = false;
-    };
-
-    Result get(QRectF rect, ClosestOption option);
-};
-
-// ===========================================================================
-
 class Graph
 {
 public:
@@ -106,12 +73,20 @@ public:
     Range range;
     int ixcol = 0;
     int iycol = 0;
+    // Range covers all rows, so rows appended to the CSV (follow mode) are
+    // added to the graph.
+    bool followsRows = false;
 
     Matrix::VectorStats xstats;
     Matrix::VectorStats ystats;
     QRectF dataBounds();
 
     GridHash grid;
+    // While the full grid hash is built in the background, grid is a coarse
+    // one of a subset of the points. Points added meanwhile are kept here to
+    // add to the full grid.
+    bool gridBuilding = false;
+    QVector<GridHash::Data> gridPending;
 
     bool isCurve();
     bool isGraph();
@@ -126,6 +101,7 @@ public:
 };
 
 typedef QSharedPointer<Graph> GraphPtr;
+typedef QWeakPointer<Graph> GraphWeakPtr;
 
 // ===========================================================================
 
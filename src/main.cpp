@@ -59,6 +59,11 @@ int main(int argc, char *argv[])
     QCommandLineOption versionOption({"v", "version"}, "Display version information");
     parser.addOption(versionOption);
 
+    QCommandLineOption importWorkersOption("import-workers",
+                                           "Number of files imported at the same time",
+                                           "count");
+    parser.addOption(importWorkersOption);
+
     parser.process(a);
 
     if (parser.isSet(versionOption)) {
@@ -68,6 +73,7 @@ int main(int argc, char *argv[])
 
     MainWindow::Args mwArgs;
     mwArgs.csvFilePath = parser.positionalArguments().value(0);
+    mwArgs.importWorkers = parser.value(importWorkersOption).toInt();
 
     MainWindow w(mwArgs);
     w.show();
@@ -20,11 +20,14 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "ArrowSource.h"
 
 #include "defer.h"
 #include "utils.h"
 #include "version.h"
 
+#include <QFileInfo>
+
 MainWindow::MainWindow(Args args, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
@@ -42,16 +45,22 @@ MainWindow::MainWindow(Args args, QWidget *parent) :
 
     connect(&csvImportDialog, &CsvImportDialog::import, this, &MainWindow::importCsv);
 
+    if (args.importWorkers > 0) {
+        csvImporter.setWorkerCount(args.importWorkers);
+    }
     csvImporter.moveToThread(&thread);
     thread.start();
     connect(&csvImporter, &CsvImporter::importFinished,
             this, &MainWindow::csvImportFinished);
     connect(&csvImporter, &CsvImporter::importProgress,
             this, &MainWindow::csvImportProgress);
+    // Not modal, so more files can be opened while importing
+    progressDialog.setWindowModality(Qt::NonModal);
+    connect(&progressDialog, &ProgressDialog::cancelClicked,
+            this, &MainWindow::cancelImports);
 
     if (!args.csvFilePath.isEmpty()) {
-        csvImportDialog.setFile(args.csvFilePath);
-        csvImportDialog.show();
+        openFile(args.csvFilePath);
     }
 
     ui->tabWidget->tabBar()->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -73,16 +82,42 @@ MainWindow::~MainWindow()
 
 void MainWindow::importCsv(Csv::FileInfo info)
 {
+    CsvPtr csv = csvImporter.importCsv(info);
+    mImports.append(csv);
+    mImportProgress.insert(csv.data(), "Waiting");
+
     progressDialog.setWindowTitle("Import CSV");
-    progressDialog.setTitle("Importing CSV file");
-    progressDialog.setInfo("");
     progressDialog.preventClose(true);
+    progressDialog.setCancelable(true);
+    updateImportProgressDialog();
     progressDialog.show();
 
-    csvImporter.importCsv(info);
     // Now we wait for the CsvImporter signal to trigger csvImportFinished().
 }
 
+void MainWindow::updateImportProgressDialog()
+{
+    progressDialog.setTitle(mImports.count() == 1
+                            ? QString("Importing CSV file")
+                            : QString("Importing %1 files").arg(mImports.count()));
+    QStringList lines;
+    foreach (CsvPtr csv, mImports) {
+        QString info = mImportProgress.value(csv.data());
+        if (mImports.count() > 1) {
+            info = QFileInfo(csv->fileInfo.filename).fileName() + ": " + info;
+        }
+        lines.append(info);
+    }
+    progressDialog.setInfo(lines.join("\n"));
+}
+
+void MainWindow::cancelImports()
+{
+    foreach (CsvPtr csv, mImports) {
+        csvImporter.cancelImport(csv);
+    }
+}
+
 PlotWindow *MainWindow::addPlot(QString title)
 {
     PlotWindow* p = new PlotWindow(++mPlotCounter);
@@ -420,12 +455,20 @@ void MainWindow::plot(CsvPtr csv, int ixcol, QList<int> iycols, Range range)
 
 void MainWindow::csvImportFinished(CsvPtr csv)
 {
+    mImports.removeAll(csv);
+    mImportProgress.remove(csv.data());
     Defer d([=]()
     {
-        progressDialog.preventClose(false);
-        progressDialog.close();
+        if (mImports.isEmpty()) {
+            progressDialog.preventClose(false);
+            progressDialog.close();
+        } else {
+            updateImportProgressDialog();
+        }
     });
 
+    if (csv->importInfo.cancelled) { return; }
+
     if (!csv->importInfo.success) {
         msgBox(csv->importInfo.info);
         return;
@@ -433,6 +476,11 @@ void MainWindow::csvImportFinished(CsvPtr csv)
 
     if (csv->matrix.isNull()) { return; }
 
+    csv->matrix->setSourceProgressCallback([this](int blocksDone, int blockCount)
+    {
+        onColumnReadProgress(blocksDone, blockCount);
+    });
+
     progressDialog.setInfo("Generating table...");
     QApplication::processEvents();
 
@@ -444,9 +492,31 @@ void MainWindow::csvImportFinished(CsvPtr csv)
     }
 }
 
-void MainWindow::csvImportProgress(CsvPtr /*csv*/, QString info)
+void MainWindow::csvImportProgress(CsvPtr csv, QString info)
+{
+    if (!mImports.contains(csv)) { return; }
+    mImportProgress.insert(csv.data(), info);
+    updateImportProgressDialog();
+}
+
+void MainWindow::onColumnReadProgress(int blocksDone, int blockCount)
 {
-    progressDialog.setInfo(info);
+    if (blocksDone >= blockCount) {
+        columnReadDialog.preventClose(false);
+        columnReadDialog.close();
+        return;
+    }
+
+    if (!columnReadDialog.isVisible()) {
+        columnReadDialog.setWindowTitle("Read columns");
+        columnReadDialog.setTitle("Reading columns from file");
+        columnReadDialog.preventClose(true);
+        columnReadDialog.show();
+    }
+    columnReadDialog.setInfo(QString("%1 %").arg((blocksDone * 100) / blockCount));
+    // Reading blocks the GUI thread. Only paint the dialog: processing events
+    // could run timers and queued signals that use the matrix being read.
+    columnReadDialog.repaint();
 }
 
 void MainWindow::msgBox(QString msg)
@@ -500,11 +570,30 @@ void MainWindow::on_action_testPlot_triggered()
 void MainWindow::on_action_importCsv_triggered()
 {
     QString filename = QFileDialog::getOpenFileName(this, "Import CSV", "",
-                                            "CSV file (*.csv);;All files (*)");
+                                            "CSV file (*.csv *.csv.gz *.csv.zst);;"
+                                            "Parquet / Arrow file (*.parquet *.arrow *.feather);;"
+                                            "All files (*)");
 
     if (filename.isEmpty()) { return; }
 
-    csvImportDialog.setFile(filename);
+    openFile(filename);
+}
+
+void MainWindow::openFile(QString filename)
+{
+    if (ArrowSource::format(filename) != ArrowSource::NoFormat) {
+        // Has its own headings and types, nothing to set up
+        Csv::FileInfo info;
+        info.filename = filename;
+        importCsv(info);
+        return;
+    }
+
+    {
+        // Before running imports
+        CsvImporter::Pause pause(&csvImporter);
+        csvImportDialog.setFile(filename);
+    }
     csvImportDialog.show();
 }
 
@@ -32,6 +32,7 @@
 #include "utils.h"
 
 #include <QFileDialog>
+#include <QHash>
 #include <QMainWindow>
 #include <QMdiSubWindow>
 #include <QMessageBox>
@@ -48,6 +49,8 @@ class MainWindow : public QMainWindow
 public:
     struct Args {
         QString csvFilePath;
+        // Files imported at the same time, 0 for the default
+        int importWorkers = 0;
     };
 
     explicit MainWindow(Args args, QWidget *parent = 0);
@@ -88,8 +91,19 @@ private slots:
 private:
     bool mDestroying = false;
     Ui::MainWindow *ui;
+    // Show import dialog for a CSV file, or import other formats directly
+    void openFile(QString filename);
     CsvImportDialog csvImportDialog {this};
     ProgressDialog progressDialog {this};
+    // Imports not finished yet and their last progress info, shown together
+    // in progressDialog
+    QList<CsvPtr> mImports;
+    QHash<Csv*, QString> mImportProgress;
+    void updateImportProgressDialog();
+    void cancelImports();
+    // Shown while columns read on demand take a while to read
+    ProgressDialog columnReadDialog {this};
+    void onColumnReadProgress(int blocksDone, int blockCount);
     AboutDialog aboutDialog {"", this};
     LinkDialog mLinkDialog {this};
 
@@ -19,35 +19,226 @@
  *****************************************************************************/
 
 #include "matrix.h"
+#include "NumberParser.h"
+#include "Timestamp.h"
+#include "utils.h"
 
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QVariant>
+#include <QtConcurrent>
 
 
 Matrix::Matrix(int numCols)
     // Add one as first column is used for index
-    : mDataCols(numCols + 1), mMetaDataCols(numCols + 1)
+    : mDataCols(numCols + 1), mBackfilledRows(numCols + 1)
 {
 
 }
 
-QVector<Matrix::MetaData> Matrix::metadataColumn(int columnIndex)
+Matrix::MetaData Matrix::metadata(int row, int col)
 {
-    return mMetaDataCols.value(columnIndex);
+    MetaData md;
+    if (cellFromRowBlocks(row, col)) {
+        const RowBlock* block = rowBlock(row);
+        if (block) {
+            md = block->metadata.value((row - block->firstRow) * block->colCount
+                                       + col - 1);
+        }
+    } else {
+        md = mErrors.value(cellKey(row, col));
+    }
+    if (row < mBackfilledRows.value(col)) {
+        md.insufficientColsError = true;
+        md.backfilledFromRow = mBackfilledRows[col];
+    }
+    md.column = col;
+    return md;
+}
+
+bool Matrix::findError(ErrorType type, bool forward, int &row, int &col)
+{
+    bool found = false;
+    qint64 foundKey = 0;
+
+    // Cells with stored metadata
+    qint64 startKey = cellKey(row, col);
+    if (forward) {
+        QMap<qint64, MetaData>::iterator it = mErrors.lowerBound(startKey);
+        for (; it != mErrors.end(); ++it) {
+            if (it.value().hasError(type)) {
+                found = true;
+                foundKey = it.key();
+                break;
+            }
+        }
+    } else {
+        QMap<qint64, MetaData>::iterator it = mErrors.upperBound(startKey);
+        while (it != mErrors.begin()) {
+            --it;
+            if (it.value().hasError(type)) {
+                found = true;
+                foundKey = it.key();
+                break;
+            }
+        }
+    }
+
+    // Backfilled cells. Check each column for the nearest one and keep it if
+    // it comes before the one found so far.
+    if ((type == AnyError) || (type == InsufficientColsError)) {
+        for (int icol = 0; icol < mBackfilledRows.count(); icol++) {
+            int backfilledRows = mBackfilledRows[icol];
+            if (backfilledRows == 0) { continue; }
+            int irow = 0;
+            if (forward) {
+                irow = (icol >= col) ? row : row + 1;
+                if (irow >= backfilledRows) { continue; }
+            } else {
+                irow = (icol <= col) ? row : row - 1;
+                if (irow < 0) { continue; }
+                irow = qMin(irow, backfilledRows - 1);
+            }
+            qint64 key = cellKey(irow, icol);
+            if (!found || (forward ? (key < foundKey) : (key > foundKey))) {
+                found = true;
+                foundKey = key;
+            }
+        }
+    }
+
+    if (found) {
+        row = foundKey >> 32;
+        col = foundKey & 0xFFFFFFFF;
+    }
+    return found;
 }
 
 QVector<double> Matrix::dataColumn(int columnIndex, int startIndex, int length)
 {
-    const QVector<double> col = mDataCols.value(columnIndex);
+    if (!colValid(columnIndex)) { return QVector<double>(); }
+
+    int end = (length < 0) ? rowCount() : (startIndex + length);
+    readFromSource(columnIndex, startIndex, end);
+    // Widen stored type to double
+    mDataCols[columnIndex].consolidate();
+    return mDataCols[columnIndex].toDoubles(startIndex, length);
+}
+
+ColumnView Matrix::columnView(int columnIndex)
+{
+    if (!colValid(columnIndex)) { return ColumnView(); }
+    readFromSource(columnIndex, 0, rowCount());
+    mDataCols[columnIndex].consolidate();
+    return mDataCols[columnIndex].view();
+}
+
+ColumnView Matrix::columnView(int columnIndex, const Range &range)
+{
+    if (!colValid(columnIndex)) { return ColumnView(); }
+    readFromSource(columnIndex, range.start, range.start + range.size());
+    mDataCols[columnIndex].consolidate();
+    return mDataCols[columnIndex].view(range.start, range.size());
+}
 
-    if ((startIndex < 0) || (startIndex >= col.length())) {
-        return QVector<double>();
+Column::Type Matrix::columnType(int columnIndex)
+{
+    if (mSource && (columnIndex > 0) && colValid(columnIndex)
+            && (mDataCols[columnIndex].count() < rowCount())) {
+        // Not read yet
+        return mSource->columnType(columnIndex - 1);
     }
+    return mDataCols.value(columnIndex).type();
+}
 
-    if ((startIndex == 0) && (length == col.length())) {
-        return col;
-    } else {
-        return col.mid(startIndex, length);
+bool Matrix::isTimeColumn(int columnIndex)
+{
+    if (mTimeCols.value(columnIndex)) { return true; }
+    return mSource && (columnIndex > 0)
+            && mSource->isTimeColumn(columnIndex - 1);
+}
+
+QVector<bool> Matrix::timeColumns()
+{
+    return mTimeCols.mid(1);
+}
+
+void Matrix::setTimeColumns(const QVector<bool> &cols)
+{
+    for (int i = 0; i < cols.count(); i++) {
+        if (cols[i]) {
+            setTimeColumn(i + 1);
+        }
+    }
+}
+
+void Matrix::setTimeColumn(int col)
+{
+    if (mTimeCols.count() <= col) {
+        mTimeCols.resize(col + 1);
+    }
+    mTimeCols[col] = true;
+}
+
+bool Matrix::isCategoryColumn(int columnIndex)
+{
+    return mCategoryCols.value(columnIndex);
+}
+
+QStringList Matrix::categories(int columnIndex)
+{
+    QStringList ret;
+    if (columnIndex < mCategories.count()) {
+        foreach (const QByteArray& text, mCategories[columnIndex].texts) {
+            ret.append(QString::fromUtf8(text));
+        }
+    }
+    return ret;
+}
+
+QString Matrix::categoryText(int columnIndex, double code)
+{
+    if ((columnIndex < 0) || (columnIndex >= mCategories.count())) {
+        return QString();
+    }
+    return QString::fromUtf8(mCategories[columnIndex].texts.value(int(code)));
+}
+
+QVector<bool> Matrix::categoryColumns()
+{
+    return mCategoryCols.mid(1);
+}
+
+void Matrix::setCategoryColumns(const QVector<bool> &cols)
+{
+    for (int i = 0; i < cols.count(); i++) {
+        if (cols[i]) {
+            setCategoryColumn(i + 1);
+        }
+    }
+}
+
+void Matrix::setCategoryColumn(int col)
+{
+    if (mCategoryCols.count() <= col) {
+        mCategoryCols.resize(col + 1);
+    }
+    mCategoryCols[col] = true;
+}
+
+int Matrix::categoryCode(int col, const QByteArray &text)
+{
+    if (mCategories.count() <= col) {
+        mCategories.resize(col + 1);
+    }
+    Categories& categories = mCategories[col];
+    int code = categories.codes.value(text, -1);
+    if (code < 0) {
+        code = categories.texts.count();
+        categories.texts.append(text);
+        categories.codes.insert(text, code);
     }
+    return code;
 }
 
 int Matrix::errorCount()
@@ -110,22 +301,505 @@ int Matrix::colCount()
     return mDataCols.count();
 }
 
+qint64 Matrix::dataMemoryUsage()
+{
+    qint64 ret = 0;
+    foreach (const Column& col, mDataCols) {
+        ret += col.memoryUsage();
+    }
+    // Category texts are shared by the list and the hash. Hash node: next
+    // pointer, hash, key, value.
+    const qint64 nodeSize = sizeof(void*) + sizeof(uint) + sizeof(QByteArray)
+            + sizeof(int);
+    foreach (const Categories& categories, mCategories) {
+        foreach (const QByteArray& text, categories.texts) {
+            ret += sizeof(QByteArray) + text.capacity() + nodeSize;
+        }
+    }
+    return ret;
+}
+
+qint64 Matrix::metadataMemoryUsage()
+{
+    qint64 ret = mBackfilledRows.capacity() * sizeof(int);
+    // Map node: key, value, parent/left/right pointers
+    const qint64 nodeSize = sizeof(qint64) + sizeof(MetaData) + 3 * sizeof(void*);
+    foreach (const MetaData& md, mErrors) {
+        ret += nodeSize + md.originalText.capacity();
+    }
+    return ret;
+}
+
+qint64 Matrix::denseMetadataMemoryUsage()
+{
+    // Flags and error strings of a cell, excluding the strings themselves
+    struct DenseMetaData {
+        bool valueConversionError;
+        bool excessColsError;
+        bool insufficientColsError;
+        QStringList errorStrings;
+    };
+    return qint64(rowCount()) * colCount() * sizeof(DenseMetaData);
+}
+
+void Matrix::reserveRows(int rows)
+{
+    for (int icol = 0; icol < mDataCols.count(); icol++) {
+        mDataCols[icol].reserve(rows);
+    }
+}
+
+void Matrix::squeeze()
+{
+    for (int icol = 0; icol < mDataCols.count(); icol++) {
+        mDataCols[icol].consolidate();
+    }
+}
+
+void Matrix::setSource(ColumnSourcePtr source)
+{
+    mSource = source;
+    int rows = source->rowCount();
+    int cols = source->columnCount() + 1;
+
+    mDataCols.fill(Column(), cols);
+    mBackfilledRows.fill(0, cols);
+    mTimeCols.clear();
+    mCategoryCols.clear();
+    mCategories.clear();
+    for (int col = 1; col < cols; col++) {
+        mBackfilledRows[col] = source->backfilledRows(col - 1);
+        if (source->isCategoryColumn(col - 1)) {
+            setCategoryColumn(col);
+        }
+    }
+    mSourceBlocksRead.fill(QBitArray(source->blockCount()), cols);
+    mRowBlocks.clear();
+    mRowBlocks.setMaxCost(qMax(rowBlockCacheSize,
+                               4 * rowBlockRows * cols * int(sizeof(double))));
+
+    Column& index = mDataCols[0];
+    index.reserve(rows);
+    for (int row = 0; row < rows; row++) {
+        index.append(row);
+    }
+}
+
+void Matrix::setSourceProgressCallback(SourceProgressCallback callback)
+{
+    mSourceProgress = callback;
+}
+
+void Matrix::readFromSource(int col, int start, int end)
+{
+    if (!mSource) { return; }
+    readFromSource(QVector<int>{col}, start, end);
+}
+
+void Matrix::readFromSource(const QVector<int>& cols, int start, int end)
+{
+    if (!mSource) { return; }
+    // Reading from within the progress callback would store blocks while an
+    // outer read is halfway through storing its own
+    Q_ASSERT(!mInSourceProgress);
+    if (mInSourceProgress) { return; }
+
+    int rows = rowCount();
+
+    // Per block, the columns not read yet, in block order
+    QMap<int, QVector<int>> blockCols;
+    foreach (int col, cols) {
+        if ((col <= 0) || (col >= colCount())) { continue; }
+        QBitArray& blocksRead = mSourceBlocksRead[col];
+        for (int block = 0; block < mSource->blockCount(); block++) {
+            if (mSource->blockStart(block) >= end) { break; }
+            if ((mSource->blockStart(block + 1) <= start)
+                    || blocksRead.testBit(block)) {
+                continue;
+            }
+            blockCols[block].append(col - 1);
+            // Only tried once, also if it fails
+            blocksRead.setBit(block);
+        }
+        Column& column = mDataCols[col];
+        if (column.count() < rows) {
+            // First read. Rows not read yet are zero.
+            column = Column(mSource->columnType(col - 1));
+            column.reserve(rows);
+            column.resize(rows);
+            // Errors of backfilled cells are implied by mBackfilledRows
+            mInsufficientColsErrorCount += mBackfilledRows[col];
+            mErrorCount += mBackfilledRows[col];
+        }
+    }
+    if (blockCols.isEmpty()) { return; }
+
+    struct BlockRead
+    {
+        int block = 0;
+        QVector<int> cols;
+        QVector<QVector<double>> values;
+        QVector<QVector<ColumnSource::Error>> errors;
+        bool ok = false;
+        QString error;
+        QFuture<void> future;
+    };
+    QVector<BlockRead> reads;
+    for (auto it = blockCols.cbegin(); it != blockCols.cend(); ++it) {
+        BlockRead read;
+        read.block = it.key();
+        read.cols = it.value();
+        reads.append(read);
+    }
+
+    ColumnSource* source = mSource.data();
+    auto readBlock = [source](BlockRead* read)
+    {
+        read->ok = source->readColumnsBlock(read->cols, read->block, read->values,
+                                            read->errors, read->error);
+    };
+    bool parallel = source->isThreadSafe() && (reads.count() > 1);
+    if (parallel) {
+        for (int i = 0; i < reads.count(); i++) {
+            BlockRead* read = &reads[i];
+            read->future = QtConcurrent::run([readBlock, read]() { readBlock(read); });
+        }
+    }
+
+    // Store blocks in order, so values with errors can get the previous
+    // row's value
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    bool progressReported = false;
+    for (int i = 0; i < reads.count(); i++) {
+        BlockRead& read = reads[i];
+        if (parallel) {
+            read.future.waitForFinished();
+        } else {
+            readBlock(&read);
+        }
+        if (mSourceProgress && (progressTimer.elapsed() > 100)) {
+            progressTimer.restart();
+            progressReported = true;
+            reportSourceProgress(i, reads.count());
+        }
+        if (!read.ok) {
+            qDebug() << "Error reading block" << read.block << "from source:"
+                     << read.error;
+            continue;
+        }
+        for (int j = 0; j < read.cols.count(); j++) {
+            storeSourceBlock(read.cols[j] + 1, read.block, read.values[j],
+                             read.errors[j]);
+        }
+        // Free memory of block read
+        read.values.clear();
+        read.errors.clear();
+    }
+
+    if (progressReported) {
+        reportSourceProgress(reads.count(), reads.count());
+    }
+}
+
+void Matrix::reportSourceProgress(int blocksDone, int blockCount)
+{
+    mInSourceProgress = true;
+    mSourceProgress(blocksDone, blockCount);
+    mInSourceProgress = false;
+}
+
+void Matrix::storeSourceBlock(int col, int block, const QVector<double>& values,
+                              const QVector<ColumnSource::Error>& errors)
+{
+    int rows = rowCount();
+    int blockStart = mSource->blockStart(block);
+
+    // Value of previous row for rows with errors. If the first row has an
+    // error and the previous block was not read, read the blocks since the
+    // last one read first so the value is the same as when reading all rows.
+    // They are read and stored in order in a single read, so this doesn't
+    // recurse further.
+    bool hasPrevious = (blockStart > 0);
+    if (hasPrevious && !errors.isEmpty() && (errors.first().row == 0)
+            && (errors.first().type != ColumnSource::Error::ExcessField)
+            && (errors.first().type != ColumnSource::Error::Category)
+            && !mSourceBlocksRead[col].testBit(block - 1)) {
+        int firstUnread = block - 1;
+        while ((firstUnread > 0)
+               && !mSourceBlocksRead[col].testBit(firstUnread - 1)) {
+            firstUnread--;
+        }
+        readFromSource(col, mSource->blockStart(firstUnread), blockStart);
+    }
+    Column& column = mDataCols[col];
+    double previous = hasPrevious ? column.at(blockStart - 1) : 0;
+
+    int iError = 0;
+    for (int i = 0; (i < values.count()) && (blockStart + i < rows); i++) {
+        double value = values[i];
+        if ((iError < errors.count()) && (errors[iError].row == i)
+                && (errors[iError].type == ColumnSource::Error::Category)) {
+            value = categoryCode(col, errors[iError++].text);
+        } else if ((iError < errors.count()) && (errors[iError].row == i)) {
+            const ColumnSource::Error& error = errors[iError++];
+            MetaData metaData = sourceErrorMetaData(error);
+            if (metaData.valueConversionError) { mValueConversionErrorCount++; }
+            if (metaData.insufficientColsError) { mInsufficientColsErrorCount++; }
+            if (metaData.excessColsError) { mExcessColsErrorCount++; }
+            mErrorCount++;
+            if (error.type != ColumnSource::Error::ExcessField) {
+                // Use previous value if any
+                if (hasPrevious) {
+                    value = previous;
+                } else {
+                    metaData.defaultedToZero = true;
+                }
+            }
+            mErrors.insert(cellKey(blockStart + i, col), metaData);
+        }
+        column.set(blockStart + i, value);
+        previous = value;
+        hasPrevious = true;
+    }
+}
+
+Matrix::MetaData Matrix::sourceErrorMetaData(const ColumnSource::Error& error)
+{
+    MetaData metaData;
+    switch (error.type) {
+    case ColumnSource::Error::Null:
+        metaData.valueConversionError = true;
+        metaData.originalText = "null";
+        break;
+    case ColumnSource::Error::ConversionError:
+        metaData.valueConversionError = true;
+        metaData.originalText = error.text;
+        break;
+    case ColumnSource::Error::MissingField:
+        metaData.insufficientColsError = true;
+        break;
+    case ColumnSource::Error::ExcessField:
+        metaData.excessColsError = true;
+        break;
+    case ColumnSource::Error::Category:
+        // Not an error
+        break;
+    }
+    return metaData;
+}
+
+int Matrix::sourceBlock(int row)
+{
+    // Last block starting at or before the row
+    int lo = 0;
+    int hi = mSource->blockCount() - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (mSource->blockStart(mid) <= row) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+bool Matrix::cellFromRowBlocks(int row, int col)
+{
+    return mSource && mSource->hasRowAccess()
+            && (col > 0) && (col < mSourceBlocksRead.count())
+            && (row >= 0) && (row < rowCount())
+            && !mSourceBlocksRead[col].testBit(sourceBlock(row));
+}
+
+const Matrix::RowBlock* Matrix::rowBlock(int row)
+{
+    int index = row / rowBlockRows;
+    const RowBlock* cached = mRowBlocks.object(index);
+    if (cached) { return cached; }
+
+    int first = index * rowBlockRows;
+    int count = qMin(rowBlockRows, rowCount() - first);
+    QVector<int> cols;
+    for (int col = 0; col < mSource->columnCount(); col++) {
+        cols.append(col);
+    }
+    QVector<QVector<double>> values;
+    QVector<QVector<ColumnSource::Error>> errors;
+    QString error;
+    if (!mSource->readRows(cols, first, count, values, errors, error)) {
+        qDebug() << "Error reading rows from source:" << error;
+        return nullptr;
+    }
+
+    // Values with errors get the previous row's value, the same as when the
+    // column is read. Those of the columns with such an error in the first
+    // row come from the rows before.
+    QVector<int> previousCols;
+    if (first > 0) {
+        for (int col = 0; col < cols.count(); col++) {
+            const QVector<ColumnSource::Error>& colErrors = errors[col];
+            if (!colErrors.isEmpty() && (colErrors.first().row == 0)
+                    && (colErrors.first().type != ColumnSource::Error::ExcessField)
+                    && (colErrors.first().type != ColumnSource::Error::Category)) {
+                previousCols.append(col);
+            }
+        }
+    }
+    QVector<double> previousValues = previousRowValues(first, previousCols);
+
+    RowBlock* block = new RowBlock();
+    block->firstRow = first;
+    block->colCount = cols.count();
+    block->values.resize(count * block->colCount);
+    for (int col = 0; col < block->colCount; col++) {
+        bool hasPrevious = (first > 0);
+        double previous = 0;
+        int iPrevious = previousCols.indexOf(col);
+        if (iPrevious >= 0) { previous = previousValues[iPrevious]; }
+        int iError = 0;
+        for (int i = 0; i < count; i++) {
+            double value = values[col][i];
+            const QVector<ColumnSource::Error>& colErrors = errors[col];
+            if ((iError < colErrors.count()) && (colErrors[iError].row == i)
+                    && (colErrors[iError].type == ColumnSource::Error::Category)) {
+                value = categoryCode(col + 1, colErrors[iError++].text);
+            } else if ((iError < colErrors.count()) && (colErrors[iError].row == i)) {
+                const ColumnSource::Error& e = colErrors[iError++];
+                MetaData metaData = sourceErrorMetaData(e);
+                if (e.type != ColumnSource::Error::ExcessField) {
+                    if (hasPrevious) {
+                        value = previous;
+                    } else {
+                        metaData.defaultedToZero = true;
+                    }
+                }
+                block->metadata.insert(i * block->colCount + col, metaData);
+            }
+            block->values[i * block->colCount + col] = value;
+            previous = value;
+            hasPrevious = true;
+        }
+    }
+
+    // Cost limited so a block with many errors still fits
+    mRowBlocks.insert(index, block, qMin(block->memoryUsage(), mRowBlocks.maxCost()));
+    return block;
+}
+
+QVector<double> Matrix::previousRowValues(int first, const QVector<int> &cols)
+{
+    QVector<double> ret(cols.count());
+    // Indexes into cols of the values not known yet
+    QVector<int> todo;
+    for (int i = 0; i < cols.count(); i++) {
+        todo.append(i);
+    }
+
+    // Walk back a row block at a time, only reading the columns of which the
+    // rows read so far all took the previous value
+    int end = first;
+    while (!todo.isEmpty() && (end > 0)) {
+        int row = end - 1;
+
+        // Known if the column was read there, or from a cached row block
+        const RowBlock* cached = mRowBlocks.object(row / rowBlockRows);
+        QVector<int> remaining;
+        foreach (int i, todo) {
+            int col = cols[i] + 1;
+            if (!cellFromRowBlocks(row, col)) {
+                ret[i] = mDataCols[col].at(row);
+            } else if (cached) {
+                ret[i] = cached->values[(row - cached->firstRow)
+                                        * cached->colCount + col - 1];
+            } else {
+                remaining.append(i);
+            }
+        }
+        todo = remaining;
+        if (todo.isEmpty()) { break; }
+
+        int start = qMax(0, end - rowBlockRows);
+        QVector<int> readCols;
+        foreach (int i, todo) {
+            readCols.append(cols[i]);
+        }
+        QVector<QVector<double>> values;
+        QVector<QVector<ColumnSource::Error>> errors;
+        QString error;
+        if (!mSource->readRows(readCols, start, end - start, values, errors,
+                               error)) {
+            qDebug() << "Error reading rows from source:" << error;
+            break;
+        }
+
+        // Last row of each column with its own value
+        remaining.clear();
+        for (int j = 0; j < todo.count(); j++) {
+            const QVector<ColumnSource::Error>& colErrors = errors[j];
+            int iError = colErrors.count() - 1;
+            bool found = false;
+            for (int k = end - start - 1; (k >= 0) && !found; k--) {
+                while ((iError >= 0) && (colErrors[iError].row > k)) {
+                    iError--;
+                }
+                if ((iError < 0) || (colErrors[iError].row != k)) {
+                    ret[todo[j]] = values[j][k];
+                    found = true;
+                } else if (colErrors[iError].type == ColumnSource::Error::Category) {
+                    ret[todo[j]] = categoryCode(readCols[j] + 1,
+                                                colErrors[iError].text);
+                    found = true;
+                } else if (colErrors[iError].type == ColumnSource::Error::ExcessField) {
+                    ret[todo[j]] = values[j][k];
+                    found = true;
+                }
+            }
+            if (!found) {
+                remaining.append(todo[j]);
+            }
+        }
+        todo = remaining;
+        end = start;
+    }
+    // Values not found before the first row are zero
+    return ret;
+}
+
+double Matrix::cellValue(int row, int col)
+{
+    if (!colValid(col) || (row < 0) || (row >= rowCount())) { return 0; }
+
+    if (cellFromRowBlocks(row, col)) {
+        const RowBlock* block = rowBlock(row);
+        if (!block) { return 0; }
+        return block->values[(row - block->firstRow) * block->colCount + col - 1];
+    }
+
+    readFromSource(col, row, row + 1);
+    return mDataCols[col].at(row);
+}
+
 void Matrix::addCsvLine(const QByteArrayList &textValues)
 {
-    QVector<Value> values(textValues.size());
+    mRowValues.resize(textValues.size());
     for (int i = 0; i < textValues.size(); ++i) {
-        Value& v = values[i];
+        Value& v = mRowValues[i];
         bool ok;
-        v.originalValue = textValues[i];
-        v.value = v.originalValue.toDouble(&ok);
-        if (!ok) {
-            // Try bool
-            v.value = convertToBool(v.originalValue, false, &ok) ? 1.0 : 0.0;
+        bool timestamp;
+        const QByteArray& text = textValues[i];
+        v.originalValue = ByteSpan(text.constData(), text.size());
+        if (mCategoryCols.value(i + 1)) {
+            v.value = categoryCode(i + 1, text);
+            v.error = false;
+            continue;
         }
-        v.error = !ok;
+        v.value = convertValue(v.originalValue, &ok, &timestamp);
+        v.error = !ok || (timestamp && !mTimeCols.value(i + 1));
     }
 
-    addRow(values);
+    addRow(mRowValues);
 }
 
 void Matrix::addRow(QVector<double> values)
@@ -140,7 +814,7 @@ void Matrix::addRow(QVector<double> values)
     addRow(values2);
 }
 
-void Matrix::addRow(QVector<Value> values)
+void Matrix::addRow(QVector<Value>& values)
 {
     // +1 as first column is index
     int max = qMax(values.count() + 1, colCount());
@@ -156,16 +830,14 @@ void Matrix::addRow(QVector<Value> values)
 
         // Add missing column if necessary
         if (icol == colCount()) {
-            mDataCols.append(QVector<double>(rowCountBeforeAdd));
-            mMetaDataCols.append(QVector<MetaData>(rowCountBeforeAdd));
+            mDataCols.append(Column());
+            mDataCols.last().resize(rowCountBeforeAdd);
+            mBackfilledRows.append(rowCountBeforeAdd);
             backfill = true;
 
             metaData.excessColsError = true;
             mExcessColsErrorCount++;
             mErrorCount++;
-            metaData.errorStrings.append(
-                        QString("Additional column %1 added, not present in previous rows.")
-                        .arg(icol));
         }
 
         if (icol == 0) {
@@ -179,19 +851,14 @@ void Matrix::addRow(QVector<Value> values)
             if (value.error) {
                 // Value conversion error
                 metaData.valueConversionError = true;
+                metaData.originalText = value.originalValue.toByteArray();
                 mValueConversionErrorCount++;
                 mErrorCount++;
                 // Use previous value if any
-                int len = mDataCols[icol].length();
-                if (len) {
-                    value.value = mDataCols[icol][len-1];
-                    metaData.errorStrings.append(
-                                QString("Value conversion error. Previous row value used. Original text: %1")
-                                .arg(QString::fromUtf8(value.originalValue)));
+                if (!mDataCols[icol].isEmpty()) {
+                    value.value = mDataCols[icol].last();
                 } else {
-                    metaData.errorStrings.append(
-                                QString("Value conversion error. Defaulted to zero. Original text: %1")
-                                .arg(QString::fromUtf8(value.originalValue)));
+                    metaData.defaultedToZero = true;
                 }
             }
             mDataCols[icol].append(value.value);
@@ -205,37 +872,239 @@ void Matrix::addRow(QVector<Value> values)
             mErrorCount++;
             // Use value of previous row if any
             double value = 0;
-            int len = mDataCols[icol].length();
-            if (len) {
-                value = mDataCols[icol][len-1];
-                metaData.errorStrings.append("No value (insufficient columns in row). Previous row value used.");
+            if (!mDataCols[icol].isEmpty()) {
+                value = mDataCols[icol].last();
             } else {
-                metaData.errorStrings.append("No value (insufficient columns in row). Defaulted to zero.");
+                metaData.defaultedToZero = true;
             }
             mDataCols[icol].append(value);
             backfillValue = value;
         }
 
-        mMetaDataCols[icol].append(metaData);
+        if (metaData.hasError()) {
+            mErrors.insert(cellKey(rowCountBeforeAdd, icol), metaData);
+        }
 
         if (backfill) {
+            // Errors of backfilled cells are implied by mBackfilledRows
             for (int irow = 0; irow < rowCountBeforeAdd; irow++) {
+                mDataCols[icol].set(irow, backfillValue);
+            }
+            mInsufficientColsErrorCount += rowCountBeforeAdd;
+            mErrorCount += rowCountBeforeAdd;
+        }
+    }
+}
+
+void Matrix::appendChunk(const Chunk &chunk)
+{
+    for (int icol = 0; icol < chunk.timeCols.count(); icol++) {
+        if (chunk.timeCols[icol]) {
+            setTimeColumn(icol + 1);
+        }
+    }
 
-                mDataCols[icol][irow] = backfillValue;
+    // Codes of the chunk's categories, which are numbered per chunk
+    QVector<QVector<int>> codes(chunk.categories.count());
+    for (int icol = 0; icol < chunk.categoryCols.count(); icol++) {
+        if (!chunk.categoryCols[icol]) { continue; }
+        setCategoryColumn(icol + 1);
+        if (icol >= chunk.categories.count()) { continue; }
+        foreach (const ByteSpan& text, chunk.categories[icol]) {
+            codes[icol].append(categoryCode(icol + 1, text.toByteArray()));
+        }
+    }
 
-                mInsufficientColsErrorCount++;
-                mErrorCount++;
+    int iError = 0;
+    int row = 0;
+    while (row < chunk.rowCount) {
+
+        int nextErrorRow = chunk.rowCount;
+        if (iError < chunk.errors.count()) {
+            nextErrorRow = chunk.errors[iError].row;
+        }
+
+        // Rows without errors that have a value for each existing column can
+        // be copied over as is. Find the run of such rows.
+        int valueColCount = colCount() - 1; // Excluding index
+        int runEnd = row;
+        while ((runEnd < nextErrorRow)
+               && (chunk.fieldCounts[runEnd] == valueColCount)) {
+            runEnd++;
+        }
+
+        if (runEnd > row) {
+            appendChunkRows(chunk, codes, row, runEnd);
+            row = runEnd;
+            continue;
+        }
+
+        // Row with errors or a different number of columns. Add it the normal
+        // way so the errors and previous/backfill values are handled exactly
+        // as if the file was imported line by line.
+        int fieldCount = chunk.fieldCounts[row];
+        mRowValues.resize(fieldCount);
+        for (int icol = 0; icol < fieldCount; icol++) {
+            Value& v = mRowValues[icol];
+            v.value = chunk.cols[icol][row];
+            if (!codes.value(icol).isEmpty()) {
+                v.value = codes[icol][int(v.value)];
+            }
+            v.error = false;
+            v.originalValue = ByteSpan();
+        }
+        while ((iError < chunk.errors.count()) && (chunk.errors[iError].row == row)) {
+            const Chunk::Error& e = chunk.errors[iError];
+            mRowValues[e.col].error = true;
+            mRowValues[e.col].originalValue = e.originalValue;
+            iError++;
+        }
+        addRow(mRowValues);
+        row++;
+    }
+}
+
+void Matrix::appendChunkRows(const Chunk &chunk,
+                             const QVector<QVector<int>> &codes, int from,
+                             int to)
+{
+    int count = to - from;
+    int firstRow = rowCount();
+
+    for (int icol = 0; icol < colCount(); icol++) {
+
+        Column& col = mDataCols[icol];
+
+        if (icol == 0) {
+            // First column is index
+            for (int i = 0; i < count; i++) {
+                col.append(firstRow + i);
+            }
+        } else if (!codes.value(icol - 1).isEmpty()) {
+            const QVector<int>& colCodes = codes[icol - 1];
+            const double* values = chunk.cols[icol - 1].constData();
+            for (int i = from; i < to; i++) {
+                col.append(colCodes[int(values[i])]);
+            }
+        } else {
+            col.append(chunk.cols[icol - 1].constData() + from, count);
+        }
+    }
+}
 
-                MetaData backfillMetaData;
-                backfillMetaData.insufficientColsError = true;
-                backfillMetaData.errorStrings.append(
-                            QString("No value (insufficient columns in row). Backfilled from row %1.")
-                            .arg(rowCount()));
+void Matrix::Chunk::addCsvLine(const QVector<ByteSpan> &textValues)
+{
+    addCsvLine(textValues.constData(), textValues.count());
+}
+
+void Matrix::Chunk::addCsvLine(const ByteSpan *textValues, int count)
+{
+    int fieldCount = count;
+
+    // Add columns not seen before in this chunk, padding previous rows
+    while (cols.count() < fieldCount) {
+        cols.append(QVector<double>(rowCount));
+    }
 
-                mMetaDataCols[icol][irow] = backfillMetaData;
+    for (int icol = 0; icol < cols.count(); icol++) {
+        double value = 0;
+        if ((icol < fieldCount) && categoryCols.value(icol)) {
+            value = categoryIndex(icol, textValues[icol]);
+        } else if (icol < fieldCount) {
+            bool ok;
+            bool timestamp;
+            value = convertValue(textValues[icol], &ok, &timestamp);
+            if (!ok || (timestamp && !timeCols.value(icol))) {
+                errors.append(Error{rowCount, icol, textValues[icol]});
             }
         }
+        cols[icol].append(value);
     }
+
+    fieldCounts.append(fieldCount);
+    rowCount++;
+}
+
+int Matrix::Chunk::categoryIndex(int col, ByteSpan text)
+{
+    if (categories.count() <= col) {
+        categories.resize(col + 1);
+        categoryIndexes.resize(col + 1);
+    }
+    QHash<ByteSpan, int>& indexes = categoryIndexes[col];
+    auto it = indexes.constFind(text);
+    if (it != indexes.constEnd()) { return it.value(); }
+    int index = categories[col].count();
+    categories[col].append(text);
+    indexes.insert(text, index);
+    return index;
+}
+
+void Matrix::ColumnSample::addLine(const QVector<ByteSpan> &textValues)
+{
+    addLine(textValues.constData(), textValues.count());
+}
+
+void Matrix::ColumnSample::addLine(const ByteSpan *textValues, int count)
+{
+    if (rowCount == 0) {
+        firstRowFieldCount = count;
+    }
+    if (counts.count() < count) {
+        counts.resize(count);
+    }
+    for (int i = 0; i < count; i++) {
+        const ByteSpan& text = textValues[i];
+        Counts& c = counts[i];
+        bool ok;
+        bool timestamp;
+        convertValue(text, &ok, &timestamp);
+        if (ok) {
+            if (c.values == 0) { c.firstValueTimestamp = timestamp; }
+            c.values++;
+            if (timestamp) { c.timestamps++; }
+        } else if (isCategoryText(text)) {
+            c.texts++;
+        }
+    }
+    rowCount++;
+}
+
+void Matrix::ColumnSample::addLine(const QByteArrayList &textValues)
+{
+    QVector<ByteSpan> spans(textValues.count());
+    for (int i = 0; i < textValues.count(); i++) {
+        spans[i] = ByteSpan(textValues[i].constData(), textValues[i].size());
+    }
+    addLine(spans);
+}
+
+QVector<bool> Matrix::ColumnSample::categoryColumns() const
+{
+    QVector<bool> ret(firstRowFieldCount);
+    for (int i = 0; i < firstRowFieldCount; i++) {
+        // Allow the odd category that looks like a number, e.g. a host
+        // named 1
+        const Counts& c = counts[i];
+        ret[i] = (c.texts > 0) && (c.values * 20 <= c.texts);
+    }
+    return ret;
+}
+
+QVector<bool> Matrix::ColumnSample::timeColumns(const QStringList &headings) const
+{
+    QVector<bool> ret(counts.count());
+    for (int i = 0; i < counts.count(); i++) {
+        const Counts& c = counts[i];
+        if (c.timestamps * 2 > c.values) {
+            ret[i] = true;
+        } else {
+            bool timeTitle = (Utils::looksLikeTimeTitle(headings.value(i))
+                              != Utils::NoMatch);
+            ret[i] = timeTitle && c.firstValueTimestamp;
+        }
+    }
+    return ret;
 }
 
 bool Matrix::colValid(int column)
@@ -243,28 +1112,56 @@ bool Matrix::colValid(int column)
     return ( (column < mDataCols.count()) && (column >= 0) );
 }
 
-bool Matrix::convertToBool(const QByteArray& data, bool defaultValue, bool* ok)
+qint64 Matrix::cellKey(int row, int col)
 {
-    bool ret = defaultValue;
+    return (qint64(row) << 32) | quint32(col);
+}
 
-    static QList<QByteArray> trues {"true", "1"};
-    static QList<QByteArray> falses {"", "false", "0"};
+double Matrix::convertValue(ByteSpan text, bool *ok, bool* timestamp)
+{
+    if (timestamp) { *timestamp = false; }
+    double value = 0;
+    *ok = NumberParser::toDouble(text.begin(), text.end(), &value);
+    if (!*ok) {
+        // Try bool
+        bool b = false;
+        *ok = NumberParser::toBool(text.begin(), text.end(), &b);
+        value = b ? 1.0 : 0.0;
+    }
+    if (!*ok) {
+        // Try date / time
+        value = 0;
+        *ok = Timestamp::toSeconds(text.begin(), text.end(), &value);
+        if (timestamp) { *timestamp = *ok; }
+    }
+    return value;
+}
 
-    QByteArray lower = data.trimmed().toLower();
-    bool found = false;
-    foreach (const QByteArray& t, trues) {
-        if (lower == t) {
-            ret = true;
-            found = true;
-        }
+bool Matrix::isCategoryText(ByteSpan text)
+{
+    if (text.isEmpty()) { return false; }
+    bool ok;
+    convertValue(text, &ok);
+    if (ok) { return false; }
+
+    // Placeholders of missing values, so a numeric column starting with one
+    // stays numeric
+    static const QList<QByteArray> missing {"n/a", "na", "nan", "null", "none",
+                                            "nil", "-", "?"};
+    if (text.size() <= 4) {
+        QByteArray lower = text.toByteArray().toLower();
+        if (missing.contains(lower)) { return false; }
     }
+    return true;
+}
+
+bool Matrix::convertToBool(const QByteArray& data, bool defaultValue, bool* ok)
+{
+    bool ret = defaultValue;
+    bool found = NumberParser::toBool(data.constData(),
+                                      data.constData() + data.size(), &ret);
     if (!found) {
-        foreach (const QByteArray& f, falses) {
-            if (lower == f) {
-                ret = false;
-                found = true;
-            }
-        }
+        ret = defaultValue;
     }
 
     if (ok) {
@@ -274,16 +1171,16 @@ bool Matrix::convertToBool(const QByteArray& data, bool defaultValue, bool* ok)
     return ret;
 }
 
-Matrix::VectorStats Matrix::vectorStats(const QVector<double> &vector)
+Matrix::VectorStats Matrix::vectorStats(const ColumnView &view)
 {
     VectorStats s;
-    if (vector.isEmpty()) { return s; }
-    s.max = vector[0];
-    s.min = vector[0];
+    if (view.isEmpty()) { return s; }
+    s.max = view[0];
+    s.min = view[0];
     s.monotonicallyIncreasing = true;
-    double lastValue = vector[0];
-    for (int i = 1; i < vector.count(); i++) {
-        double value = vector[i];
+    double lastValue = view[0];
+    for (int i = 1; i < view.count(); i++) {
+        double value = view[i];
         if (value < s.min) { s.min = value; }
         if (value > s.max) { s.max = value; }
         if (value < lastValue) { s.monotonicallyIncreasing = false; }
@@ -293,6 +1190,22 @@ Matrix::VectorStats Matrix::vectorStats(const QVector<double> &vector)
     return s;
 }
 
+void Matrix::extendVectorStats(VectorStats &stats, const ColumnView &view, int from)
+{
+    if (from <= 0) {
+        stats = vectorStats(view);
+        return;
+    }
+    double lastValue = view[from - 1];
+    for (int i = from; i < view.count(); i++) {
+        double value = view[i];
+        if (value < stats.min) { stats.min = value; }
+        if (value > stats.max) { stats.max = value; }
+        if (value < lastValue) { stats.monotonicallyIncreasing = false; }
+        lastValue = value;
+    }
+}
+
 bool Matrix::MetaData::hasError()
 {
     return valueConversionError
@@ -300,7 +1213,51 @@ bool Matrix::MetaData::hasError()
             || insufficientColsError;
 }
 
+bool Matrix::MetaData::hasError(ErrorType type)
+{
+    switch (type) {
+    case AnyError:
+        return hasError();
+    case ValueConversionError:
+        return valueConversionError;
+    case ExcessColsError:
+        return excessColsError;
+    case InsufficientColsError:
+        return insufficientColsError;
+    }
+    return false;
+}
+
 QString Matrix::MetaData::errorString()
 {
+    QStringList errorStrings;
+
+    if (excessColsError) {
+        errorStrings.append(
+                    QString("Additional column %1 added, not present in previous rows.")
+                    .arg(column));
+    }
+
+    if (valueConversionError) {
+        errorStrings.append(
+                    QString("Value conversion error. %1 Original text: %2")
+                    .arg(defaultedToZero ? "Defaulted to zero."
+                                         : "Previous row value used.")
+                    .arg(QString::fromUtf8(originalText)));
+    }
+
+    if (insufficientColsError) {
+        if (backfilledFromRow >= 0) {
+            // Row numbers are shown from 1 in the table
+            errorStrings.append(
+                        QString("No value (insufficient columns in row). Backfilled from row %1.")
+                        .arg(backfilledFromRow + 1));
+        } else if (defaultedToZero) {
+            errorStrings.append("No value (insufficient columns in row). Defaulted to zero.");
+        } else {
+            errorStrings.append("No value (insufficient columns in row). Previous row value used.");
+        }
+    }
+
     return errorStrings.join('\n');
 }
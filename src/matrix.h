@@ -21,28 +21,91 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "ByteSpan.h"
+#include "Column.h"
+#include "ColumnSource.h"
+#include "Range.h"
+
+#include <QBitArray>
+#include <QCache>
+#include <QFile>
+#include <QHash>
+#include <QMap>
 #include <QPoint>
 #include <QSharedPointer>
 #include <QStringList>
 #include <QVector>
 
+#include <functional>
+
 class Matrix
 {
 public:
+    enum ErrorType {
+        AnyError,
+        ValueConversionError,
+        ExcessColsError,
+        InsufficientColsError
+    };
+
     struct MetaData
     {
         bool valueConversionError = false;
         bool excessColsError = false;
         bool insufficientColsError = false;
         bool hasError();
-        QStringList errorStrings;
+        bool hasError(ErrorType type);
+        // Formatted from the details below on request
         QString errorString();
+
+        int column = 0;
+        // No previous row value to use
+        bool defaultedToZero = false;
+        // Row from which the column was added, for backfilled cells
+        int backfilledFromRow = -1;
+        // Text of value that failed conversion
+        QByteArray originalText;
     };
 
     Matrix(int numCols);
 
     QVector<double> dataColumn(int columnIndex, int startIndex = 0, int length = -1);
-    QVector<MetaData> metadataColumn(int columnIndex);
+    // Views of column data without copying it. Valid until the matrix is
+    // modified.
+    ColumnView columnView(int columnIndex);
+    ColumnView columnView(int columnIndex, const Range& range);
+    MetaData metadata(int row, int col);
+    /* Find the first cell with an error of the specified type, from the cell
+     * at row, col (inclusive) onwards in row by row order, or backwards if
+     * forward is false. Returns false if there is none, otherwise sets row
+     * and col to the cell found. */
+    bool findError(ErrorType type, bool forward, int& row, int& col);
+    // Type the column values are stored as
+    Column::Type columnType(int columnIndex);
+    /* Whether values of the column are timestamps, in seconds since the
+     * epoch (see Timestamp). Decided from the first data rows (see
+     * ColumnSample), or by the source. Date or time text in other columns
+     * are value conversion errors. */
+    bool isTimeColumn(int columnIndex);
+    // Per column excluding the index column, as for Chunk::timeCols
+    QVector<bool> timeColumns();
+    // Set before adding lines with addCsvLine(). Per column excluding the
+    // index column.
+    void setTimeColumns(const QVector<bool>& cols);
+    /* Whether the column holds categories, e.g. state or host names. Its
+     * values are codes indexing the column's category texts, in order of
+     * first appearance. Which columns are category columns is decided from
+     * the first data rows (see ColumnSample), in which case all its fields
+     * are taken as text, also those that look like numbers. */
+    bool isCategoryColumn(int columnIndex);
+    QStringList categories(int columnIndex);
+    // Text of a category code, empty if there is no such category
+    QString categoryText(int columnIndex, double code);
+    // Per column excluding the index column, as for Chunk::categoryCols
+    QVector<bool> categoryColumns();
+    // Set before adding lines with addCsvLine(). Per column excluding the
+    // index column.
+    void setCategoryColumns(const QVector<bool>& cols);
 
     int errorCount();
     int valueConversionErrorCount();
@@ -57,21 +120,143 @@ public:
     int rowCount();
     int colCount();
 
+    // Bytes used by the column values
+    qint64 dataMemoryUsage();
+    // Approximate bytes used by the error metadata
+    qint64 metadataMemoryUsage();
+    // Bytes that metadata for every cell would use
+    qint64 denseMetadataMemoryUsage();
+
+    // Reserve column storage for an expected number of rows
+    void reserveRows(int rows);
+    // Make column storage contiguous and release unused reserved memory. Done
+    // automatically when column data is accessed.
+    void squeeze();
+
     void addCsvLine(const QByteArrayList &textValues);
     void addRow(QVector<double> values);
 
+    /* Read columns on demand from source instead of adding rows, e.g. for
+     * Parquet files or CSV files of which only the lines were indexed. Only
+     * the index column is filled here. Other columns are read when a view of
+     * them is taken, only the source blocks containing the rows of the view.
+     * Null values are value conversion errors. Errors are only known for the
+     * rows read so far. */
+    void setSource(ColumnSourcePtr source);
+    /* Value of a single cell, e.g. for a table. If the source can read rows
+     * (see ColumnSource::hasRowAccess()), cells of columns not read yet are
+     * read with the rest of their row, in small blocks of rows of which the
+     * most recently used are cached, so any row can be shown without
+     * reading whole columns. metadata() gets their errors the same way. */
+    double cellValue(int row, int col);
+    /* Called now and then while reading from the source takes a while, from
+     * the thread reading, which is blocked meanwhile. Finally called with
+     * blocksDone equal to blockCount. The callback must not use the matrix
+     * (e.g. by running an event loop), as the read is not finished. */
+    typedef std::function<void(int blocksDone, int blockCount)>
+            SourceProgressCallback;
+    void setSourceProgressCallback(SourceProgressCallback callback);
+
+    /* A Chunk holds the converted values of a block of consecutive CSV lines.
+     * Chunks can be filled independently (e.g. in parallel threads) and are
+     * then appended to the matrix in file order with appendChunk(), which
+     * gives the same result as adding the lines one by one with
+     * addCsvLine(). The text spans must stay valid until then. */
+    struct Chunk
+    {
+        void addCsvLine(const QVector<ByteSpan> &textValues);
+        void addCsvLine(const ByteSpan* textValues, int count);
+
+        int rowCount = 0;
+        // Values: [col][row], excluding index column. Rows with fewer fields
+        // than there are columns are padded with zeros.
+        QVector<QVector<double>> cols;
+        QVector<int> fieldCounts;
+
+        struct Error {
+            int row = 0;
+            int col = 0;
+            ByteSpan originalValue;
+        };
+        QVector<Error> errors; // Value conversion errors in row order
+        // Per column, whether it holds timestamps. Set before adding lines,
+        // the same as categoryCols. May be shorter than cols.
+        QVector<bool> timeCols;
+
+        /* Per column, whether its fields are category texts. Set before
+         * adding lines: from the first data rows (see ColumnSample), or from
+         * the matrix (see categoryColumns()) for lines appended to it. May be
+         * shorter than cols. */
+        QVector<bool> categoryCols;
+        // Per category column, its texts in order of first appearance. Its
+        // values index these and are mapped to the matrix codes when
+        // appended.
+        QVector<QVector<ByteSpan>> categories;
+        QVector<QHash<ByteSpan, int>> categoryIndexes;
+        int categoryIndex(int col, ByteSpan text);
+    };
+    void appendChunk(const Chunk& chunk);
+
+    /* Counts of the kinds of fields in the first data rows, to decide which
+     * columns hold categories and timestamps before the rows are converted.
+     * A single field doesn't decide it, so a numeric column starting with
+     * e.g. ERR, a unit or a heading line taken as data stays numeric. */
+    struct ColumnSample
+    {
+        static const int maxRows = 100;
+
+        void addLine(const QVector<ByteSpan>& textValues);
+        void addLine(const ByteSpan* textValues, int count);
+        void addLine(const QByteArrayList& textValues);
+        bool isFull() const { return rowCount >= maxRows; }
+
+        /* Per column, whether it holds categories: it has text (see
+         * isCategoryText()) and (almost) none of its fields are numbers,
+         * bools or timestamps. Only columns of the first row can, as columns
+         * added by later rows are backfilled. */
+        QVector<bool> categoryColumns() const;
+        /* Per column, whether it holds timestamps: most of its values are
+         * timestamps, or its heading looks like a time (see
+         * Utils::looksLikeTimeTitle()) and its first value is a timestamp.
+         * headings exclude the index column. */
+        QVector<bool> timeColumns(const QStringList& headings) const;
+
+        int rowCount = 0;
+        int firstRowFieldCount = 0;
+        struct Counts {
+            int texts = 0;
+            // Numbers, bools and timestamps
+            int values = 0;
+            int timestamps = 0;
+            bool firstValueTimestamp = false;
+        };
+        QVector<Counts> counts;
+    };
+
     bool colValid(int column);
 
-    bool convertToBool(const QByteArray &data, bool defaultValue, bool* ok = nullptr);
+    // Number, bool or timestamp. timestamp is set if the text was a date or
+    // time.
+    static double convertValue(ByteSpan text, bool* ok, bool* timestamp = nullptr);
+    static bool convertToBool(const QByteArray &data, bool defaultValue, bool* ok = nullptr);
+    // Whether a field makes its column a category column, i.e. is not empty,
+    // not a number, bool or timestamp and not a placeholder such as n/a
+    static bool isCategoryText(ByteSpan text);
 
     struct VectorStats {
         double min = 0;
         double max = 0;
         bool monotonicallyIncreasing = false;
     };
-    static VectorStats vectorStats(const QVector<double> &vector);
+    static VectorStats vectorStats(const ColumnView &view);
+    // Update stats of view[0, from) with the values from index from onwards
+    static void extendVectorStats(VectorStats& stats, const ColumnView &view,
+                                  int from);
 
 private:
+    // Reads and writes the members below directly
+    friend class CsvCache;
+
     QStringList mHeadings;
     int mErrorCount = 0;
     int mValueConversionErrorCount = 0;
@@ -81,13 +266,92 @@ private:
     struct Value {
         double value = 0;
         bool error = true;
-        QByteArray originalValue;
+        ByteSpan originalValue;
     };
-    void addRow(QVector<Value> values);
+    void addRow(QVector<Value>& values);
+    // codes: per chunk column, the matrix codes of its category indexes
+    void appendChunkRows(const Chunk& chunk, const QVector<QVector<int>>& codes,
+                         int from, int to);
+    // Reused for every CSV line to avoid allocating per line
+    QVector<Value> mRowValues;
 
-    // Data and meta mDataCols matrices: [col][row]. First column is index
-    QVector<QVector<double>> mDataCols;
-    QVector<QVector<MetaData>> mMetaDataCols;
+    ColumnSourcePtr mSource;
+    SourceProgressCallback mSourceProgress;
+    // Set while the progress callback runs, to catch it using the matrix
+    bool mInSourceProgress = false;
+    void reportSourceProgress(int blocksDone, int blockCount);
+    // Per column, the source blocks read so far
+    QVector<QBitArray> mSourceBlocksRead;
+    // Read the source blocks of rows [start, end) not read yet
+    void readFromSource(int col, int start, int end);
+    void readFromSource(const QVector<int>& cols, int start, int end);
+    void storeSourceBlock(int col, int block, const QVector<double>& values,
+                          const QVector<ColumnSource::Error>& errors);
+    static MetaData sourceErrorMetaData(const ColumnSource::Error& error);
+    // Source block containing a row
+    int sourceBlock(int row);
+
+    struct RowBlock
+    {
+        int firstRow = 0;
+        // Excluding index column
+        int colCount = 0;
+        // [row * colCount + col], with the values of errors replaced the same
+        // as when the columns are read
+        QVector<double> values;
+        QHash<int, MetaData> metadata;
+        int memoryUsage() const
+        {
+            return values.count() * int(sizeof(double))
+                    + metadata.count() * int(sizeof(MetaData));
+        }
+    };
+    static const int rowBlockRows = 256;
+    static const int rowBlockCacheSize = 64 * 1024 * 1024;
+    // Keyed by row / rowBlockRows. Cost is memory usage.
+    QCache<int, RowBlock> mRowBlocks;
+    // Whether a cell is read with its row instead of its column
+    bool cellFromRowBlocks(int row, int col);
+    // Null if the rows can't be read
+    const RowBlock* rowBlock(int row);
+    /* Values of row first - 1 of the source columns cols, as cellValue()
+     * would give them, for the errors in the first row of a row block. Rows
+     * before it are read as needed, without recursing per row block. */
+    QVector<double> previousRowValues(int first, const QVector<int>& cols);
+
+    // Memory-mapped cache file the columns point into, if loaded from one.
+    // Declared before the columns so it outlives them.
+    QSharedPointer<QFile> mCacheFile;
+
+    // Data columns: [col][row]. First column is index
+    QVector<Column> mDataCols;
+
+    // Errors are rare, so metadata is only kept for cells with errors, keyed
+    // by cellKey() which orders them by row, then column.
+    QMap<qint64, MetaData> mErrors;
+    static qint64 cellKey(int row, int col);
+    // Number of rows each column was backfilled for, i.e. the row from which
+    // the column was added. Every backfilled cell has the same error, so it
+    // is not stored per cell.
+    QVector<int> mBackfilledRows;
+    // Per column, whether it holds timestamps. May be shorter than the
+    // column count.
+    QVector<bool> mTimeCols;
+    void setTimeColumn(int col);
+
+    struct Categories
+    {
+        QVector<QByteArray> texts;
+        QHash<QByteArray, int> codes;
+    };
+    // Per column, whether it holds categories. May be shorter than the
+    // column count.
+    QVector<bool> mCategoryCols;
+    // Per column, its categories. May be shorter than the column count.
+    QVector<Categories> mCategories;
+    void setCategoryColumn(int col);
+    // Code of a category text, added if new
+    int categoryCode(int col, const QByteArray& text);
 };
 typedef QSharedPointer<Matrix> MatrixPtr;
 
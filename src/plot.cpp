@@ -20,6 +20,12 @@
 
 #include "plot.h"
 
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include <limits>
+
 Plot::GenericMarkerData Plot::copiedMarkerData;
 
 
@@ -113,9 +119,31 @@ void Plot::onActionDataTipGraphSelected(GraphPtr graph)
 Plot::ClosestCoord Plot::findClosestCoord(QPoint mousePos, GraphPtr graph,
                                           ClosestOption closestOption)
 {
+    // Graphs have sorted keys and are searched directly instead of with a
+    // grid hash
+    if (graph->isGraph()) {
+        return findClosestGraphCoord(mousePos, graph->graph, closestOption);
+    }
+
     ClosestCoord closest;
 
-    int px = mClosestCoordStartSizePx;
+    // Start with a search area of about a grid cell, so that a lookup in
+    // dense data only scans the points in a few cells. The area doubles from
+    // there until a point is found, which costs little for the empty cells.
+    const GridHash& grid = graph->grid;
+    QPointF cellCorner = grid.bounds.topLeft()
+            + QPointF(grid.cellSize().width(), grid.cellSize().height());
+    QPoint cellPx = coordToPixelPos(cellCorner)
+            - coordToPixelPos(grid.bounds.topLeft());
+    int px = qBound(mClosestCoordMinSizePx,
+                    qMax(qAbs(cellPx.x()), qAbs(cellPx.y())),
+                    mClosestCoordStartSizePx);
+
+    // Map coordinates to pixels in blocks with the kernel if the mapping is
+    // linear, otherwise one at a time with coordToPixelPos().
+    ClosestKernel::PixelMap pixelMap;
+    bool useKernel = linearPixelMap(pixelMap)
+            && ((closestOption == ClosestXY) || (pixelMap.xy == 0));
 
     while (!closest.valid) {
 
@@ -137,8 +165,6 @@ Plot::ClosestCoord Plot::findClosestCoord(QPoint mousePos, GraphPtr graph,
         // used to look up coordinates in the grid hash.
         QRectF searchRect = searchPoly.boundingRect();
 
-        GridHash::Result r = graph->grid.get(searchRect, closestOption);
-
         // Use a distance limit effectively only accept coordinates in a
         // circle radius around the mouse position. (Otherwise we could
         // potentially leave out closer points depending on the plot
@@ -146,26 +172,115 @@ Plot::ClosestCoord Plot::findClosestCoord(QPoint mousePos, GraphPtr graph,
         double limitDistSqr = px*px;
 
         double closestDistSqr = 0;
-        bool first = true;
-        foreach (GridHash::Data d, r.data) {
-            QPoint pixelPos = coordToPixelPos(d.coord);
-            double distSqr;
+        auto consider = [&](double distSqr, const QPointF& coord, int index)
+        {
+            if ( (!closest.valid || (distSqr < closestDistSqr)) && (distSqr <= limitDistSqr) ) {
+                closestDistSqr = distSqr;
+                closest.coord = coord;
+                closest.dataIndex = index;
+                closest.valid = true;
+            }
+        };
+
+        bool maxedOut;
+        if (useKernel) {
+            maxedOut = grid.visitBlocks(searchRect, closestOption,
+                    [&](const QPointF* coords, const int* indexes, int count)
+            {
+                ClosestKernel::Result r = ClosestKernel::closest(
+                            coords, count, pixelMap, mousePos, closestOption);
+                if (r.position < 0) { return; }
+                consider(r.distSqr, coords[r.position], indexes[r.position]);
+            });
+        } else {
+            maxedOut = grid.visit(searchRect, closestOption,
+                                  [&](const QPointF& coord, int index)
+            {
+                QPoint pixelPos = coordToPixelPos(coord);
+                double dx = mousePos.x() - pixelPos.x();
+                double distSqr = dx * dx;
+                if (closestOption == ClosestXY) {
+                    double dy = mousePos.y() - pixelPos.y();
+                    distSqr += dy * dy;
+                }
+                consider(distSqr, coord, index);
+            });
+        }
+
+        if (maxedOut) { break; }
+
+        // Next iteration, if no coord found, try again with larger area
+        px *= 2;
+    }
+
+    return closest;
+}
+
+
+bool Plot::linearPixelMap(ClosestKernel::PixelMap& /*map*/)
+{
+    return false;
+}
+
+Plot::ClosestCoord Plot::findClosestGraphCoord(QPoint mousePos, QCPGraph* graph,
+                                               ClosestOption closestOption)
+{
+    ClosestCoord closest;
+
+    QSharedPointer<QCPGraphDataContainer> data = graph->data();
+    if (data->isEmpty()) { return closest; }
+
+    QCPGraphDataContainer::const_iterator begin = data->constBegin();
+    QCPGraphDataContainer::const_iterator end = data->constEnd();
+
+    double closestDistSqr = 0;
+    auto scan = [&](QCPGraphDataContainer::const_iterator from,
+                    QCPGraphDataContainer::const_iterator to,
+                    double limitDistSqr)
+    {
+        for (QCPGraphDataContainer::const_iterator it = from; it != to; ++it) {
+            QPointF coord(it->key, it->value);
+            QPoint pixelPos = coordToPixelPos(coord);
+            double dx = mousePos.x() - pixelPos.x();
+            double distSqr = dx * dx;
             if (closestOption == ClosestXY) {
-                distSqr = qPow(mousePos.x() - pixelPos.x(), 2)
-                        + qPow(mousePos.y() - pixelPos.y(), 2);
-            } else {
-                distSqr = qPow(mousePos.x() - pixelPos.x(), 2);
+                double dy = mousePos.y() - pixelPos.y();
+                distSqr += dy * dy;
             }
-            if ( (first || (distSqr < closestDistSqr)) && (distSqr <= limitDistSqr) ) {
-                first = false;
+            if ( (!closest.valid || (distSqr < closestDistSqr)) && (distSqr <= limitDistSqr) ) {
                 closestDistSqr = distSqr;
-                closest.coord = d.coord;
-                closest.dataIndex = d.index;
+                closest.coord = coord;
+                closest.dataIndex = it - begin;
                 closest.valid = true;
             }
         }
+    };
+
+    if (closestOption == ClosestXOnly) {
+        // The closest x is one of the two points either side of the mouse
+        // position's key, found with a binary search.
+        double key = pixelPosToCoord(mousePos).x();
+        QCPGraphDataContainer::const_iterator it = data->findBegin(key, false);
+        QCPGraphDataContainer::const_iterator from = (it == begin) ? it : it - 1;
+        QCPGraphDataContainer::const_iterator to = (it == end) ? it : it + 1;
+        scan(from, to, std::numeric_limits<double>::infinity());
+        return closest;
+    }
+
+    // Closest in x and y: only the points within px of the mouse's x can be
+    // within the distance limit. The window grows until a point is found.
+    int px = mClosestCoordStartSizePx;
+    while (!closest.valid) {
+        double key1 = pixelPosToCoord(mousePos - QPoint(px, 0)).x();
+        double key2 = pixelPosToCoord(mousePos + QPoint(px, 0)).x();
+        QCPGraphDataContainer::const_iterator from =
+                data->findBegin(qMin(key1, key2), false);
+        QCPGraphDataContainer::const_iterator to =
+                data->findEnd(qMax(key1, key2), false);
 
-        if (r.maxedOut) { break; }
+        scan(from, to, (double)px * px);
+
+        if ((from == begin) && (to == end)) { break; }
 
         // Next iteration, if no coord found, try again with larger area
         px *= 2;
@@ -174,3 +289,78 @@ Plot::ClosestCoord Plot::findClosestCoord(QPoint mousePos, GraphPtr graph,
     return closest;
 }
 
+void Plot::buildGrid(GraphPtr graph, QRectF bounds, int count,
+                     std::function<QPointF(int)> coordAt)
+{
+    graph->gridPending.clear();
+
+    if (count < mGridBackgroundMinCount) {
+        QVector<QPointF> coords(count);
+        for (int i = 0; i < count; i++) {
+            coords[i] = coordAt(i);
+        }
+        graph->grid.build(bounds, coords);
+        graph->gridBuilding = false;
+        return;
+    }
+
+    // Coarse grid of evenly spaced points to find the closest points with
+    // until the full grid is ready
+    int step = (count + mCoarseGridCount - 1) / mCoarseGridCount;
+    QVector<QPointF> coords;
+    QVector<int> indexes;
+    coords.reserve(count / step + 1);
+    indexes.reserve(count / step + 1);
+    for (int i = 0; i < count; i += step) {
+        coords.append(coordAt(i));
+        indexes.append(i);
+    }
+    graph->grid.build(bounds, coords, indexes);
+    graph->gridBuilding = true;
+
+    QFutureWatcher<GridHash>* watcher = new QFutureWatcher<GridHash>(this);
+    connect(watcher, &QFutureWatcher<GridHash>::finished,
+            this, [this, watcher, graphWkPtr = graph.toWeakRef()]()
+    {
+        watcher->deleteLater();
+        GraphPtr graph(graphWkPtr);
+        if (!graph || !mGraphs.contains(graph)) { return; }
+
+        GridHash grid = watcher->result();
+        for (const GridHash::Data& d : qAsConst(graph->gridPending)) {
+            grid.insert(d.coord, d.index);
+        }
+        graph->gridPending.clear();
+        graph->gridPending.squeeze();
+
+        // Lookups only happen on this thread, so the full grid takes over
+        // from the coarse one in one go.
+        graph->grid = grid;
+        graph->gridBuilding = false;
+
+        qDebug() << "Search index ready:" << graph->name()
+                 << graph->grid.count() << "points,"
+                 << graph->grid.resolution() << "x" << graph->grid.resolution()
+                 << "cells," << graph->grid.memoryUsage() << "bytes, built in"
+                 << graph->grid.buildTimeMs() << "ms";
+    });
+
+    watcher->setFuture(QtConcurrent::run([bounds, count, coordAt]()
+    {
+        QVector<QPointF> coords(count);
+        for (int i = 0; i < count; i++) {
+            coords[i] = coordAt(i);
+        }
+        GridHash grid;
+        grid.build(bounds, coords);
+        return grid;
+    }));
+}
+
+void Plot::insertGridPoint(GraphPtr graph, QPointF coord, int index)
+{
+    graph->grid.insert(coord, index);
+    if (graph->gridBuilding) {
+        graph->gridPending.append(GridHash::Data{coord, index});
+    }
+}
@@ -21,6 +21,7 @@
 #ifndef PLOT_H
 #define PLOT_H
 
+#include "ClosestKernel.h"
 #include "link.h"
 #include "graph.h"
 
@@ -145,6 +146,9 @@ protected:
 
     virtual QPointF pixelPosToCoord(QPoint pos) = 0;
     virtual QPoint coordToPixelPos(QPointF coord) = 0;
+    // Set map to the mapping of coordToPixelPos() (without rounding) and
+    // return true if it is linear. Returns false by default.
+    virtual bool linearPixelMap(ClosestKernel::PixelMap& map);
 
     struct ClosestCoord {
         bool valid = false;
@@ -153,10 +157,24 @@ protected:
     };
 
     int mClosestCoordStartSizePx = 50;
+    int mClosestCoordMinSizePx = 4;
     ClosestCoord findClosestCoord(QPoint mousePos, GraphPtr graph,
                                   ClosestOption closestOption);
 
+    // Grids of more points than this are built on a worker thread, with a
+    // coarse grid of about mCoarseGridCount points used until then.
+    int mGridBackgroundMinCount = 100000;
+    int mCoarseGridCount = 10000;
+    // Build the graph's grid hash from count points. coordAt may be called
+    // from a worker thread so must only use data that won't change.
+    void buildGrid(GraphPtr graph, QRectF bounds, int count,
+                   std::function<QPointF(int)> coordAt);
+    void insertGridPoint(GraphPtr graph, QPointF coord, int index);
+
 private:
+    ClosestCoord findClosestGraphCoord(QPoint mousePos, QCPGraph* graph,
+                                       ClosestOption closestOption);
+
     void setupPlotMenu();
 private slots:
     void onActionDataTipGraphSelected(GraphPtr graph);
@@ -19,9 +19,14 @@
  *****************************************************************************/
 
 #include "subplot.h"
+#include "DecimatedCurve.h"
+#include "PyramidGraph.h"
+#include "Timestamp.h"
 
 #include "utils.h"
 
+#include <cmath>
+
 
 Subplot::Subplot(QCPAxisRect *axisRect, QWidget *parentWidget)
     : Plot{parentWidget}, axisRect(axisRect)
@@ -152,6 +157,25 @@ void Subplot::onLegendItemRightClicked(QCPPlottableLegendItem *legendItem,
     // Menu title simply displaying plot color and name
     menu->addAction(PlotMenu::createColorIcon(plottable->pen().color()),
                     plottable->name());
+    PyramidGraph* pyramidGraph = qobject_cast<PyramidGraph*>(plottable);
+    if (pyramidGraph) {
+        QAction* info = menu->addAction(
+                    QString("Sampling pyramid: %1")
+                    .arg(QLocale().formattedDataSize(
+                             pyramidGraph->pyramidMemoryUsage())));
+        info->setEnabled(false);
+    }
+    if (!graph->isGraph()) {
+        QString text = "Search index: building...";
+        if (!graph->gridBuilding) {
+            text = QString("Search index: %1, %2x%2 cells, built in %3 ms")
+                    .arg(QLocale().formattedDataSize(graph->grid.memoryUsage()))
+                    .arg(graph->grid.resolution())
+                    .arg(graph->grid.buildTimeMs());
+        }
+        QAction* gridInfo = menu->addAction(text);
+        gridInfo->setEnabled(false);
+    }
 
     menu->addAction(QIcon("://edit"), "Rename",
                     this, [this, graphWkPtr = graph.toWeakRef()]()
@@ -200,9 +224,17 @@ void Subplot::plot(CsvPtr csv, int ixcol, int iycol, Range range)
     if (iycol >= csv->matrix->colCount()) { return; }
 
     bool firstPlot = (axisRect->plottables().size() == 0);
+    bool xTime = csv->matrix->isTimeColumn(ixcol);
+    bool yCategory = csv->matrix->isCategoryColumn(iycol);
+    if (firstPlot) {
+        setXTime(xTime);
+        setYCategories(yCategory ? csv : CsvPtr(), iycol);
+    }
 
-    QVector<double> x = csv->matrix->dataColumn(ixcol, range.start, range.size());
-    QVector<double> y = csv->matrix->dataColumn(iycol, range.start, range.size());
+    // Views into the matrix, the values are only copied into the plottable
+    ColumnView x = csv->matrix->columnView(ixcol, range);
+    ColumnView y = csv->matrix->columnView(iycol, range);
+    int count = qMin(x.count(), y.count());
 
     Matrix::VectorStats xstats = Matrix::vectorStats(x);
     Matrix::VectorStats ystats = Matrix::vectorStats(y);
@@ -219,26 +251,50 @@ void Subplot::plot(CsvPtr csv, int ixcol, int iycol, Range range)
     if (xstats.monotonicallyIncreasing) {
         // Graph is more efficient but can only be used if x is monotonically
         // increasing
-        QCPGraph* qcpgraph = mPlot->addGraph(xAxis, yAxis);
+        PyramidGraph* qcpgraph = new PyramidGraph(xAxis, yAxis);
         graph.reset(new Graph(qcpgraph));
-        qcpgraph->setData(x, y);
+        QVector<QCPGraphData> points(count);
+        for (int i = 0; i < count; i++) {
+            points[i] = QCPGraphData(x[i], y[i]);
+        }
+        QSharedPointer<QCPGraphDataContainer> data(new QCPGraphDataContainer());
+        data->set(points, true);
+        qcpgraph->setData(data);
+        qcpgraph->updatePyramid();
         qcpgraph->setPen(pen);
         qcpgraph->setName(name);
+        if (yCategory) {
+            // State plot: each category holds until the next one
+            qcpgraph->setLineStyle(QCPGraph::lsStepLeft);
+        }
         mPlotCrosshairSnap = ClosestXOnly;
         mPlotCrosshair->showHorizontalLine = false;
         queueReplot();
     } else {
-        // Curve is used otherwise
-        QCPCurve* qcpcurve = new QCPCurve(xAxis, yAxis);
+        // Curve is used otherwise, decimated as it has no adaptive sampling
+        QCPCurve* qcpcurve = new DecimatedCurve(xAxis, yAxis);
         graph.reset(new Graph(qcpcurve));
-        qcpcurve->setData(x, y);
+        QVector<QCPCurveData> points(count);
+        for (int i = 0; i < count; i++) {
+            points[i] = QCPCurveData(i, x[i], y[i]);
+        }
+        QSharedPointer<QCPCurveDataContainer> data(new QCPCurveDataContainer());
+        data->set(points, true);
+        qcpcurve->setData(data);
         qcpcurve->setPen(pen);
         qcpcurve->setName(name);
         mPlotCrosshairSnap = ClosestXY;
-        setEqualAxesButDontReplot(true);
+        // Equal axes make no sense for seconds or categories against other
+        // units
+        if (!xTime && !yCategory) {
+            setEqualAxesButDontReplot(true);
+        }
     }
     graph->csv = csv;
     graph->range = range;
+    graph->ixcol = ixcol;
+    graph->iycol = iycol;
+    graph->followsRows = range.sameAs(csv->allRange());
     graph->xstats = xstats;
     graph->ystats = ystats;
     mGraphs.append(graph);
@@ -247,9 +303,25 @@ void Subplot::plot(CsvPtr csv, int ixcol, int iycol, Range range)
     // Record min/max for all graphs
     expandBounds(graph->dataBounds());
 
-    graph->grid.bounds = graph->dataBounds();
-    for (int i = 0; i < x.count(); i++) {
-        graph->grid.insert(QPointF(x[i], y[i]), i);
+    // Graphs are searched by key and don't need a grid hash
+    if (!graph->isGraph()) {
+        // Copied as the views may not outlive a background build
+        QVector<QPointF> coords(count);
+        for (int i = 0; i < count; i++) {
+            coords[i] = QPointF(x[i], y[i]);
+        }
+        buildGrid(graph, graph->dataBounds(), count,
+                  [coords](int i) { return coords[i]; });
+    }
+
+    if (graph->followsRows) {
+        connect(csv.data(), &Csv::rowsAppended,
+                this, [this, graphWkPtr = graph.toWeakRef()](int firstRow, int count)
+        {
+            GraphPtr graph(graphWkPtr);
+            if (!graph || !mGraphs.contains(graph)) { return; }
+            appendGraphRows(graph, firstRow, count);
+        });
     }
 
     legend->addItem(new QCPPlottableLegendItem(legend, graph->plottable()));
@@ -287,6 +359,66 @@ void Subplot::plot(CsvPtr csv, int ixcol, int iycol, Range range)
     }
 }
 
+void Subplot::appendGraphRows(GraphPtr graph, int firstRow, int count)
+{
+    if (!graph->followsRows) { return; }
+
+    MatrixPtr mat = graph->csv->matrix;
+    // Index in graph data of first new row
+    int from = firstRow - graph->range.start;
+    if (from != graph->dataCount()) { return; }
+
+    Range range = graph->range;
+    range.end = firstRow + count;
+    ColumnView x = mat->columnView(graph->ixcol, range);
+    ColumnView y = mat->columnView(graph->iycol, range);
+
+    Matrix::VectorStats xstats = graph->xstats;
+    Matrix::extendVectorStats(xstats, x, from);
+    if (graph->isGraph() && !xstats.monotonicallyIncreasing) {
+        // A graph keeps its data sorted by x, which would mix up the new
+        // points. Changing it to a curve would mean rebuilding the plot.
+        qDebug() << "Graph stopped following new rows as x is no longer increasing:"
+                 << graph->name();
+        graph->followsRows = false;
+        return;
+    }
+    graph->xstats = xstats;
+    Matrix::extendVectorStats(graph->ystats, y, from);
+    graph->range = range;
+
+    if (graph->isGraph()) {
+        QVector<QCPGraphData> points(count);
+        for (int i = 0; i < count; i++) {
+            points[i] = QCPGraphData(x[from + i], y[from + i]);
+        }
+        graph->graph->data()->add(points, true);
+        static_cast<PyramidGraph*>(graph->graph)->updatePyramid();
+    } else {
+        QVector<QCPCurveData> points(count);
+        for (int i = 0; i < count; i++) {
+            points[i] = QCPCurveData(from + i, x[from + i], y[from + i]);
+        }
+        graph->curve->data()->add(points, true);
+
+        // Points outside the grid's bounds end up in the edge cells, where
+        // they are still found.
+        for (int i = from; i < from + count; i++) {
+            insertGridPoint(graph, QPointF(x[i], y[i]), i);
+        }
+    }
+
+    expandBounds(graph->dataBounds());
+
+    if ((graph->csv == mYCategoryCsv) && (graph->iycol == mYCategoryCol)) {
+        // Rows may have new categories
+        updateYCategoryTicks();
+    }
+
+    // Replot is queued so many appends result in one replot
+    queueReplot();
+}
+
 void Subplot::setXLabel(QString xlabel, bool visible)
 {
     mXlabel = xlabel;
@@ -460,12 +592,97 @@ void Subplot::syncDataTip(int index)
     double y = dataTipGraph->datay(index);
     mPlotCrosshair->position->setCoords(x, y);
     mPlotCrosshair->text = QString("%1, %2 [%3]")
-            .arg(x)
-            .arg(y)
+            .arg(xText(x))
+            .arg(yText(y))
             .arg(index);
     queueReplot();
 }
 
+void Subplot::setXTime(bool time)
+{
+    mXTime = time;
+    if (time) {
+        QSharedPointer<QCPAxisTickerDateTime> ticker(new QCPAxisTickerDateTime());
+        // Timestamps without a zone are parsed as UTC, so show them as such
+        ticker->setDateTimeSpec(Qt::UTC);
+        xAxis->setTicker(ticker);
+        updateXTimeFormat();
+    } else {
+        xAxis->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTicker()));
+    }
+}
+
+void Subplot::updateXTimeFormat()
+{
+    QSharedPointer<QCPAxisTickerDateTime> ticker =
+            xAxis->ticker().dynamicCast<QCPAxisTickerDateTime>();
+    if (!ticker) { return; }
+
+    double span = xAxis->range().size();
+    QString format;
+    if (span < 60) {
+        format = "hh:mm:ss.zzz";
+    } else if (span < 86400) {
+        format = "hh:mm:ss";
+    } else if (span < 86400 * 30) {
+        format = "hh:mm\nyyyy-MM-dd";
+    } else {
+        format = "yyyy-MM-dd";
+    }
+    ticker->setDateTimeFormat(format);
+}
+
+QString Subplot::xText(double x)
+{
+    if (mXTime) {
+        return Timestamp::toString(x);
+    }
+    return QString::number(x);
+}
+
+void Subplot::setYCategories(CsvPtr csv, int col)
+{
+    mYCategoryCsv = csv;
+    mYCategoryCol = col;
+    if (csv) {
+        updateYCategoryTicks();
+    } else {
+        yAxis->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTicker()));
+    }
+}
+
+void Subplot::updateYCategoryTicks()
+{
+    QStringList categories = mYCategoryCsv->matrix->categories(mYCategoryCol);
+    if (categories.count() > maxCategoryTicks) {
+        // Too many to label, the data tips still show them
+        yAxis->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTicker()));
+        return;
+    }
+
+    QSharedPointer<QCPAxisTickerText> ticker =
+            yAxis->ticker().dynamicCast<QCPAxisTickerText>();
+    if (!ticker) {
+        ticker.reset(new QCPAxisTickerText());
+        ticker->setSubTickCount(0);
+        yAxis->setTicker(ticker);
+    }
+    QMap<double, QString> ticks;
+    for (int code = 0; code < categories.count(); code++) {
+        ticks.insert(code, categories[code]);
+    }
+    ticker->setTicks(ticks);
+}
+
+QString Subplot::yText(double y)
+{
+    // Only at the codes, e.g. not for the mouse position
+    if (mYCategoryCsv && (y == std::floor(y))) {
+        return mYCategoryCsv->matrix->categoryText(mYCategoryCol, y);
+    }
+    return QString::number(y);
+}
+
 void Subplot::resized()
 {
     if (mEqualAxes) {
@@ -722,8 +939,8 @@ void Subplot::onActionCopyCurveCoordinateTriggered()
     if (!closest.valid) { return; }
 
     QGuiApplication::clipboard()->setText(QString("%1, %2")
-                                          .arg(closest.coord.x())
-                                          .arg(closest.coord.y()));
+                                          .arg(xText(closest.coord.x()))
+                                          .arg(yText(closest.coord.y())));
 }
 
 void Subplot::onActionCopyCurveIndexTriggered()
@@ -748,7 +965,7 @@ void Subplot::onActionCopyMouseCoordinateTriggered()
     QPointF coord = pixelPosToCoord(mouse.lastMovePos);
 
     QGuiApplication::clipboard()->setText(QString("%1, %2")
-                                          .arg(coord.x())
+                                          .arg(xText(coord.x()))
                                           .arg(coord.y()));
 }
 
@@ -922,14 +1139,18 @@ bool Subplot::plotMouseMove(QMouseEvent *event)
                 // Update the plot crosshair
                 // If it takes too long to update, disable the plot crosshair
                 // automatically. However, if the user has enabled it, leave
-                // it alone.
-                if ((timer.elapsed() > 100) && !mPlotCrosshairVisibilityChangedByUser) {
+                // it alone. Snapping to x on a graph is a binary search and
+                // never slow.
+                bool searchedByKey = dataTipGraph->isGraph()
+                        && (mPlotCrosshairSnap == ClosestXOnly);
+                if ((timer.elapsed() > 100) && !searchedByKey
+                        && !mPlotCrosshairVisibilityChangedByUser) {
                     setPlotCrosshairVisible(false);
                 } else if (closest.valid) {
                     mPlotCrosshair->position->setCoords(closest.coord);
                     mPlotCrosshair->text = QString("%1, %2 [%3]")
-                            .arg(closest.coord.x())
-                            .arg(closest.coord.y())
+                            .arg(xText(closest.coord.x()))
+                            .arg(yText(closest.coord.y()))
                             .arg(closest.dataIndex);
                     emit dataTipChanged(link->group,
                                 closest.dataIndex + dataTipGraph->range.start);
@@ -1226,8 +1447,8 @@ bool Subplot::markerRightClick(QPoint pos)
         // Copy coordinate to OS clipboard
         QGuiApplication::clipboard()->setText(
                     QString("%1, %2")
-                    .arg(m->xCoord)
-                    .arg(m->yCoord));
+                    .arg(xText(m->xCoord))
+                    .arg(yText(m->yCoord)));
     });
 
     QAction* measureAction = menu->addAction(QIcon("://measure"),
@@ -1306,8 +1527,8 @@ void Subplot::updateMarkerText(MarkerPtr marker)
 {
     QString text = marker->text;
     text.replace("$i", QString::number(marker->dataIndex));
-    text.replace("$x", QString::number(marker->xCoord));
-    text.replace("$y", QString::number(marker->yCoord));
+    text.replace("$x", xText(marker->xCoord));
+    text.replace("$y", yText(marker->yCoord));
     text.replace("$name", marker->datasetName);
     text.replace("$$", "$");
     marker->textItem->setText(text);
@@ -1422,6 +1643,29 @@ QPoint Subplot::coordToPixelPos(QPointF coord)
                   yAxis->coordToPixel(coord.y()));
 }
 
+bool Subplot::linearPixelMap(ClosestKernel::PixelMap& map)
+{
+    if ((xAxis->scaleType() != QCPAxis::stLinear)
+            || (yAxis->scaleType() != QCPAxis::stLinear)) {
+        return false;
+    }
+
+    // Work out scale and offset from the axis range ends
+    QCPRange xrange = xAxis->range();
+    QCPRange yrange = yAxis->range();
+    if ((xrange.size() == 0) || (yrange.size() == 0)) { return false; }
+
+    double x0 = xAxis->coordToPixel(xrange.lower);
+    double y0 = yAxis->coordToPixel(yrange.lower);
+    map.xx = (xAxis->coordToPixel(xrange.upper) - x0) / xrange.size();
+    map.dx = x0 - map.xx * xrange.lower;
+    map.yy = (yAxis->coordToPixel(yrange.upper) - y0) / yrange.size();
+    map.dy = y0 - map.yy * yrange.lower;
+    map.xy = 0;
+    map.yx = 0;
+    return true;
+}
+
 void Subplot::onPlotMouseMove(QMouseEvent *event)
 {
     // Note: Do not limit to axisRect as mouse may be outside of window but
@@ -1527,6 +1771,10 @@ void Subplot::plotLeftClicked(const QPoint& /*pos*/)
 
 void Subplot::onAxisRangesChanged()
 {
+    if (mXTime) {
+        updateXTimeFormat();
+    }
+
     // If range change is due to a sync from another linked plot, ignore it as
     // to not create a possible infinite loop.
     if (mRangesSyncedFromOutside) {
@@ -108,6 +108,26 @@ private:
     QCPAxis* yAxis = nullptr;
     void queueReplot();
 
+    // X values are timestamps (see Matrix::isTimeColumn()), shown as dates
+    // and times
+    bool mXTime = false;
+    void setXTime(bool time);
+    // Date/time format of the x axis ticks for the current range
+    void updateXTimeFormat();
+    // Text of an x value for data tips, markers and the clipboard
+    QString xText(double x);
+
+    // Y values are category codes of this column (see
+    // Matrix::isCategoryColumn()), shown as the category texts. Null if not.
+    CsvPtr mYCategoryCsv;
+    int mYCategoryCol = -1;
+    void setYCategories(CsvPtr csv, int col);
+    // Y axis ticks at the codes, labelled with the texts
+    void updateYCategoryTicks();
+    static const int maxCategoryTicks = 1000;
+    // Text of a y value, as for xText()
+    QString yText(double y);
+
     QString mXlabel;
     bool mXlabelVisible = false;
     QString mYlabel;
@@ -184,6 +204,8 @@ private:
 
     QMap<QCPAbstractPlottable*, GraphPtr> plottableGraphMap;
     void setDataTipGraph(GraphPtr graph);
+    // Add rows appended to the graph's CSV (follow mode)
+    void appendGraphRows(GraphPtr graph, int firstRow, int count);
 
     // -------------------------------------------------------------------------
     // Markers
@@ -236,6 +258,7 @@ private:
 
     QPointF pixelPosToCoord(QPoint pos);
     QPoint coordToPixelPos(QPointF coord);
+    bool linearPixelMap(ClosestKernel::PixelMap& map);
 
 private slots:
     void onPlotMousePress(QMouseEvent* event);
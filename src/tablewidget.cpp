@@ -20,10 +20,13 @@
 
 #include "tablewidget.h"
 #include "ui_tablewidget.h"
+#include "Timestamp.h"
 
 #include "utils.h"
 
 #include <QFileInfo>
+#include <QHeaderView>
+#include <QInputDialog>
 #include <QScrollBar>
 #include <QDebug>
 
@@ -49,9 +52,27 @@ void TableWidget::setData(CsvPtr csv)
     MatrixPtr mat = csv->matrix;
 
     // Fill column tree widgets
-    foreach (QString heading, mat->getHeadingsForExistingColumns()) {
-        ui->treeWidget_cols_x->addTopLevelItem(new QTreeWidgetItem({heading}));
-        ui->treeWidget_cols_y->addTopLevelItem(new QTreeWidgetItem({heading}));
+    QList<QTreeWidget*> trees {ui->treeWidget_cols_x, ui->treeWidget_cols_y};
+    QStringList headings = mat->getHeadingsForExistingColumns();
+    for (int icol = 0; icol < headings.count(); icol++) {
+        QString heading = headings[icol];
+        QString tooltip = QString("%1 (stored as %2)")
+                .arg(heading)
+                .arg(Column::typeName(mat->columnType(icol)));
+        if (mat->isTimeColumn(icol)) {
+            tooltip = QString("%1 (timestamps, stored as %2 seconds since 1970)")
+                    .arg(heading)
+                    .arg(Column::typeName(mat->columnType(icol)));
+        } else if (mat->isCategoryColumn(icol)) {
+            tooltip = QString("%1 (categories, stored as %2 codes)")
+                    .arg(heading)
+                    .arg(Column::typeName(mat->columnType(icol)));
+        }
+        foreach (QTreeWidget* tree, trees) {
+            QTreeWidgetItem* item = new QTreeWidgetItem({heading});
+            item->setToolTip(0, tooltip);
+            tree->addTopLevelItem(item);
+        }
     }
     selectDefaultColumns();
 
@@ -71,16 +92,67 @@ void TableWidget::setData(CsvPtr csv)
 
     loadVisibleRows();
 
+    // Rows can be filtered by a category column
+    QHeaderView* header = w->horizontalHeader();
+    header->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(header, &QHeaderView::customContextMenuRequested,
+            this, &TableWidget::onHeaderContextMenuRequested);
+
     // Update info in GUI
 
     ui->lineEdit_filename->setText(csv->fileInfo.filename);
-    ui->label_loadtime->setText(QString("Loaded in %1 s")
-                                    .arg(csv->importInfo.timeSecs));
+    QString method = csv->importInfo.memoryMapped ? "memory-mapped" : "read";
+    if (!csv->importInfo.format.isEmpty()) {
+        method = csv->importInfo.format + ", columns read when used";
+    } else if (csv->importInfo.lazy) {
+        method = "lines indexed, columns read when used";
+    } else if (csv->importInfo.fromCache) {
+        method = "from cache file";
+    } else if (!csv->importInfo.compression.isEmpty()) {
+        method = csv->importInfo.compression + " decompressed";
+    }
+    QString loadInfo = QString("Loaded in %1 s (%2)")
+            .arg(csv->importInfo.timeMs / 1000.0, 0, 'f', 3)
+            .arg(method);
+    if (csv->importInfo.peakMemory >= 0) {
+        loadInfo += QString(", peak memory %1")
+                .arg(QLocale().formattedDataSize(csv->importInfo.peakMemory));
+    }
+    if (!csv->importInfo.info.isEmpty()) {
+        // E.g. a decompression error after which the rest was not loaded
+        loadInfo += "\n" + csv->importInfo.info;
+    }
+    ui->label_loadtime->setText(loadInfo);
+    updateInfo();
+
+    setupRangeComboBox();
+
+    connect(csv.data(), &Csv::rowsAppended, this, &TableWidget::onRowsAppended);
+}
+
+void TableWidget::updateInfo()
+{
+    MatrixPtr mat = mCsv->matrix;
+
     ui->label_filesize->setText(QLocale().formattedDataSize(
-        QFileInfo(csv->fileInfo.filename).size()));
-    ui->label_colsrows->setText(QString("%1 columns, %2 rows")
-                                    .arg(mat->colCount())
-                                    .arg(mat->rowCount()));
+        QFileInfo(mCsv->fileInfo.filename).size()));
+    QString colsRows = QString("%1 columns, %2 rows")
+            .arg(mat->colCount())
+            .arg(mat->rowCount());
+    if (mFilterCol >= 0) {
+        colsRows += QString("\n%1 rows shown (%2 = %3)")
+                .arg(mFilterShownRows)
+                .arg(mat->heading(mFilterCol))
+                .arg(mat->categoryText(mFilterCol, mFilterCode));
+    }
+    ui->label_colsrows->setText(colsRows);
+    qint64 metadataMemory = mat->metadataMemoryUsage();
+    ui->label_memory->setText(QString("Memory: %1 data, %2 error info (%3 saved)")
+                                  .arg(QLocale().formattedDataSize(mat->dataMemoryUsage()))
+                                  .arg(QLocale().formattedDataSize(metadataMemory))
+                                  .arg(QLocale().formattedDataSize(
+                                      qMax<qint64>(0, mat->denseMetadataMemoryUsage()
+                                                      - metadataMemory))));
 
     ui->label_errors_total->setText(QString("%1 errors").arg(mat->errorCount()));
     ui->label_errors_value->setText(QString("%1 value errors")
@@ -89,8 +161,6 @@ void TableWidget::setData(CsvPtr csv)
                                          .arg(mat->excessColsErrorCount()));
     ui->label_errors_insufCols->setText(QString("%1 insufficient column errors")
                                         .arg(mat->insufficientColsErrorCount()));
-
-    setupRangeComboBox();
 }
 
 void TableWidget::setAddToPlotButtonEnabled(bool enabled)
@@ -104,14 +174,40 @@ void TableWidget::onRangeAdded(RangePtr range)
     addRangeToComboBoxAndMap(range);
 }
 
+void TableWidget::onRowsAppended(int firstRow, int count)
+{
+    MatrixPtr mat = mCsv->matrix;
+    QTableWidget* w = ui->tableWidget;
+
+    w->setRowCount(mat->rowCount());
+    if (w->columnCount() != mat->colCount()) {
+        // A row had more columns than before
+        w->setColumnCount(mat->colCount());
+        w->setHorizontalHeaderLabels(mat->getHeadingsForExistingColumns());
+    }
+    applyFilter(firstRow, firstRow + count);
+    loadVisibleRows();
+
+    updateInfo();
+
+    allRange = mCsv->allRange();
+    if (ui->comboBox_range->currentIndex() == comboBoxAllIndex) {
+        ui->lineEdit_range->setText(allRange.toRangeString());
+    }
+}
+
 void TableWidget::loadVisibleRows()
 {
     QTableWidget* w = ui->tableWidget; // Shorthand
 
     if (w->rowCount() == 0) { return; }
-    int visibleCount = w->viewport()->height() / w->rowHeight(0);
-    int rowFirst = w->verticalScrollBar()->value();
-    int rowLast = rowFirst + visibleCount;
+    // From the positions, as rows may be hidden by a filter
+    int rowFirst = w->rowAt(0);
+    int rowLast = w->rowAt(w->viewport()->height() - 1);
+    if (rowFirst < 0) { return; }
+    if (rowLast < 0) {
+        rowLast = w->rowCount() - 1;
+    }
 
     loadRows(rowFirst, rowLast);
 }
@@ -123,19 +219,30 @@ void TableWidget::loadRows(int from, int to)
     QTableWidget* w = ui->tableWidget;
 
     to = qMin(to, mat->rowCount() - 1);
+    if (from > to) { return; }
 
-    for (int icol = 0; icol < mat->colCount(); icol++) {
-
-        QVector<double> col = mat->dataColumn(icol);
-        QVector<Matrix::MetaData> metaCol = mat->metadataColumn(icol);
+    // Cells of columns read on demand are read with their rows if possible,
+    // otherwise only the blocks of the rows shown are read
+    int errorCount = mat->errorCount();
 
+    for (int icol = 0; icol < mat->colCount(); icol++) {
+        bool time = mat->isTimeColumn(icol);
+        bool category = mat->isCategoryColumn(icol);
         for (int irow = from; irow <= to; irow++) {
 
             if (w->item(irow, icol)) { continue; } // Skip those already filled
-
-            QTableWidgetItem* cell = new QTableWidgetItem(QString::number(col[irow]));
+            if (w->isRowHidden(irow)) { continue; }
+
+            double value = mat->cellValue(irow, icol);
+            QString text = QString::number(value);
+            if (time) {
+                text = Timestamp::toString(value);
+            } else if (category) {
+                text = mat->categoryText(icol, value);
+            }
+            QTableWidgetItem* cell = new QTableWidgetItem(text);
             cell->setFlags(cell->flags() & ~Qt::ItemIsEditable);
-            Matrix::MetaData md = metaCol[irow];
+            Matrix::MetaData md = mat->metadata(irow, icol);
             if (md.hasError()) {
                 cell->setBackgroundColor(Qt::red);
                 cell->setToolTip(md.errorString());
@@ -143,6 +250,86 @@ void TableWidget::loadRows(int from, int to)
             w->setItem(irow, icol, cell);
         }
     }
+
+    if (mat->errorCount() != errorCount) {
+        // Errors of the blocks read
+        updateInfo();
+    }
+}
+
+void TableWidget::onHeaderContextMenuRequested(const QPoint &pos)
+{
+    if (!mCsv) { return; }
+    MatrixPtr mat = mCsv->matrix;
+    QHeaderView* header = ui->tableWidget->horizontalHeader();
+    int col = header->logicalIndexAt(pos);
+
+    QMenu* menu = new QMenu();
+    connect(menu, &QMenu::aboutToHide, this, [=]() { menu->deleteLater(); });
+
+    if ((col >= 0) && mat->isCategoryColumn(col)) {
+        menu->addAction(QString("Show only rows with %1...").arg(mat->heading(col)),
+                        this, [this, mat, col]()
+        {
+            QStringList categories = mat->categories(col);
+            bool ok = false;
+            QString text = QInputDialog::getItem(
+                        this, "Filter Rows",
+                        QString("Show rows where %1 is").arg(mat->heading(col)),
+                        categories, 0, false, &ok);
+            if (!ok) { return; }
+            setFilter(col, categories.indexOf(text));
+        });
+    }
+    if (mFilterCol >= 0) {
+        menu->addAction("Show all rows", this, [this]()
+        {
+            setFilter(-1, -1);
+        });
+    }
+
+    if (menu->isEmpty()) {
+        delete menu;
+        return;
+    }
+    menu->popup(header->mapToGlobal(pos));
+}
+
+void TableWidget::setFilter(int col, int code)
+{
+    mFilterCol = col;
+    mFilterCode = code;
+    mFilterShownRows = 0;
+    applyFilter(0, mCsv->matrix->rowCount());
+    updateInfo();
+    loadVisibleRows();
+}
+
+void TableWidget::applyFilter(int from, int to)
+{
+    MatrixPtr mat = mCsv->matrix;
+    QTableWidget* w = ui->tableWidget;
+
+    if (mFilterCol < 0) {
+        for (int row = from; row < to; row++) {
+            if (w->isRowHidden(row)) {
+                w->setRowHidden(row, false);
+            }
+        }
+        return;
+    }
+
+    // Codes compared directly, without the texts
+    ColumnView codes = mat->columnView(mFilterCol, Range(from, to));
+    for (int i = 0; i < codes.count(); i++) {
+        bool hidden = (codes[i] != mFilterCode);
+        if (!hidden) {
+            mFilterShownRows++;
+        }
+        if (w->isRowHidden(from + i) != hidden) {
+            w->setRowHidden(from + i, hidden);
+        }
+    }
 }
 
 void TableWidget::selectDefaultColumns()
@@ -152,7 +339,8 @@ void TableWidget::selectDefaultColumns()
 
     // X-axis selection
     // If there are <= 2 columns (including index), select index column (0) for x-axis,
-    // Otherwise try to select a column that looks like time for x-axis,
+    // Otherwise try to select a column that looks like time for x-axis, by
+    // its title or by holding timestamps,
     // otherwise first column (index 1) if there are more than 1 columns
 
     QStringList headings = mat->getHeadingsForExistingColumns();
@@ -161,6 +349,7 @@ void TableWidget::selectDefaultColumns()
 
     if (headings.count() > 2) {
         int iExact = -1;
+        int iTimestamps = -1;
         int iContain = -1;
         for (int i = 0; i < headings.count(); i++) {
             Utils::Match match = Utils::looksLikeTimeTitle(mat->heading(i));
@@ -168,6 +357,9 @@ void TableWidget::selectDefaultColumns()
                 iExact = i;
                 break;
             }
+            if (mat->isTimeColumn(i) && (iTimestamps < 0)) {
+                iTimestamps = i;
+            }
             if ((match == Utils::ContainsMatch) && (iContain < 0)) {
                 iContain = i;
             }
@@ -176,6 +368,9 @@ void TableWidget::selectDefaultColumns()
         if (iExact >= 0) {
             // Select exact match
             iSelect = iExact;
+        } else if (iTimestamps >= 0) {
+            // Select first column of dates / times
+            iSelect = iTimestamps;
         } else if (iContain >= 0) {
             // Select semi match
             iSelect = iContain;
@@ -222,34 +417,32 @@ void TableWidget::showNextError(ErrorType errorType, bool nextNotPrev)
         }
     }
 
+    Matrix::ErrorType matrixErrorType = Matrix::AnyError;
+    switch (errorType) {
+    case All:
+        matrixErrorType = Matrix::AnyError;
+        break;
+    case ValueError:
+        matrixErrorType = Matrix::ValueConversionError;
+        break;
+    case ExcessCols:
+        matrixErrorType = Matrix::ExcessColsError;
+        break;
+    case InsufCols:
+        matrixErrorType = Matrix::InsufficientColsError;
+        break;
+    }
+
     bool found = false;
     int irow = istartrow;
     int icol = istartcol;
-    int incr = nextNotPrev ? 1 : -1;
-    for (irow = istartrow; (irow >= 0) && (irow < rowCount); irow += incr) {
-        if (irow > istartrow) { istartcol = 0; }
-        if (irow < istartrow) { istartcol = colCount - 1; }
-        for (icol = istartcol; (icol >= 0) && (icol < colCount); icol += incr) {
-            Matrix::MetaData md = mCsv->matrix->metadataColumn(icol)[irow];
-            switch (errorType) {
-            case All:
-                found = md.hasError();
-                break;
-            case ValueError:
-                found = md.valueConversionError;
-                break;
-            case ExcessCols:
-                found = md.excessColsError;
-                break;
-            case InsufCols:
-                found = md.insufficientColsError;
-                break;
-            }
-            if (found) { break; }
-        }
-        if (found) { break; }
+    if ((irow >= 0) && (irow < rowCount)) {
+        found = mCsv->matrix->findError(matrixErrorType, nextNotPrev, irow, icol);
     }
+
     if (found) {
+        // Rows are only filled when shown
+        loadRows(irow, irow);
         ui->tableWidget->scrollToItem(ui->tableWidget->item(irow, icol));
         ui->tableWidget->setCurrentCell(irow, icol);
         ui->tableWidget->setFocus();
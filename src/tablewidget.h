@@ -50,6 +50,8 @@ signals:
 
 private slots:
     void onRangeAdded(RangePtr range);
+    void onRowsAppended(int firstRow, int count);
+    void onHeaderContextMenuRequested(const QPoint& pos);
 
     void on_toolButton_errors_value_prev_clicked();
     void on_toolButton_errors_value_next_clicked();
@@ -75,10 +77,20 @@ private:
 
     CsvPtr mCsv;
 
+    void updateInfo();
     void loadVisibleRows();
     void loadRows(int from, int to);
     void selectDefaultColumns();
 
+    // Only rows of which category column mFilterCol has code mFilterCode
+    // are shown, if mFilterCol is not -1
+    int mFilterCol = -1;
+    int mFilterCode = -1;
+    int mFilterShownRows = 0;
+    void setFilter(int col, int code);
+    // Hide or show rows [from, to) for the filter
+    void applyFilter(int from, int to);
+
     enum ErrorType {All, ValueError, ExcessCols, InsufCols};
     void showNextError(ErrorType errorType, bool nextNotPrev);
 